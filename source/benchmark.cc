@@ -0,0 +1,118 @@
+/* file: benchmark.cc
+  Copyright (C) 2008 Ville-Petteri Makinen
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the
+  Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+  CITATION (if not provided by software website)
+    Makinen V-P, software name, URL:http://www.iki.fi/~vpmakine/
+
+  CONTACT (if not provided by citation)
+    Ville-Petteri Makinen
+ 
+    Folkhalsan Research Center
+    Biomedicum Helsinki P.O.Box 63
+    Haartmaninkatu 8 00014, Helsinki, Finland
+    Tel: +358 9 191 25462
+    Fax: +358 9 191 25452
+
+    WWW:   http://www.iki.fi/~vpmakine
+*/
+
+#include <chrono>
+#include <string.h>
+#include "familyobject.h"
+
+/*
+ * Microbenchmark of the repulsion kernels. Random branch frames are
+ * evaluated by every kernel the processor supports and the results are
+ * compared against the scalar kernel. Build with
+ *
+ *   g++ -std=c++17 -O2 -o benchmark benchmark.cc *.cpp -lm -pthread
+ */
+static double
+measure(Layout& lt, const unsigned int reps) {
+  unsigned int i, k;
+  chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+  for(k = 0; k < reps; k++)
+    for(i = 0; i < lt.size; i++)
+      lt.forces(i);
+  chrono::duration<double> dt = (chrono::steady_clock::now() - t0);
+  double n_pairs = 0.5*(lt.size)*(lt.size - 1.0)*reps;
+  return 1e9*dt.count()/n_pairs;
+}
+
+/*
+ *
+ */
+int
+main() {
+  unsigned int i, k;
+  unsigned int sizes[] = {16, 32, 64, 128, 256, 512, 1024, 2048, 4096};
+  const char* names[] = {"scalar", "avx2", "avx512"};
+  string automatic = Layout::kernel();
+  RNG rng(1, "benchmark");
+
+  printf("Default kernel: %s\n\n", automatic.c_str());
+  printf("%8s %12s %12s %12s\n", "branches", "scalar ns", "avx2", "avx512");
+  for(k = 0; k < (sizeof(sizes)/sizeof(unsigned int)); k++) {
+    unsigned int n = sizes[k];
+    unsigned int reps = (unsigned int)(4e7/n/n) + 1;
+    Layout lt;
+    lt.size = n;
+    lt.x.resize(n); lt.y.resize(n);
+    lt.width.resize(n); lt.height.resize(n);
+    lt.fx.resize(n); lt.fy.resize(n);
+    for(i = 0; i < n; i++) {
+      lt.x[i] = 10.0*sqrt(n)*rng.uniform();
+      lt.y[i] = 10.0*sqrt(n)*rng.uniform();
+      lt.width[i] = (1.0 + 5.0*rng.uniform());
+      lt.height[i] = (1.0 + 3.0*rng.uniform());
+    }
+
+    /* Reference results. */
+    vector<float> ref(2*n*n, 0.0);
+    Layout::kernel("scalar");
+    for(i = 0; i < n; i++) {
+      lt.forces(i);
+      memcpy(&(ref[2*n*i]), lt.fx.data(), n*sizeof(float));
+      memcpy(&(ref[2*n*i + n]), lt.fy.data(), n*sizeof(float));
+    }
+    double base = measure(lt, reps);
+    printf("%8u %12.2f", n, base);
+
+    /* Vector kernels. */
+    unsigned int m;
+    for(m = 1; m < 3; m++) {
+      if(!Layout::kernel(names[m])) {
+	printf(" %12s", "n/a");
+	continue;
+      }
+      bool same = true;
+      for(i = 0; i < n; i++) {
+	lt.forces(i);
+	size_t len = (n - i - 1)*sizeof(float);
+	same &= (memcmp(&(ref[2*n*i + i + 1]), &(lt.fx[i + 1]), len) == 0);
+	same &= (memcmp(&(ref[2*n*i + n + i + 1]), &(lt.fy[i + 1]), len) == 0);
+      }
+      double t = measure(lt, reps);
+      printf(" %11.2fx%s", base/t, (same ? "" : "!"));
+    }
+    printf("\n");
+  }
+  printf("\nTimes are per branch pair; '!' marks results that differ from\n");
+  printf("the scalar kernel.\n");
+  return 0;
+}
@@ -0,0 +1,99 @@
+/* file: columnindex.cpp
+  Copyright (C) 2008 Ville-Petteri Makinen
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the
+  Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+  CITATION (if not provided by software website)
+    Makinen V-P, software name, URL:http://www.iki.fi/~vpmakine/
+
+  CONTACT (if not provided by citation)
+    Ville-Petteri Makinen
+ 
+    Folkhalsan Research Center
+    Biomedicum Helsinki P.O.Box 63
+    Haartmaninkatu 8 00014, Helsinki, Finland
+    Tel: +358 9 191 25462
+    Fax: +358 9 191 25452
+
+    WWW:   http://www.iki.fi/~vpmakine
+*/
+
+#include "table.h"
+
+/*
+ *
+ */
+ColumnIndex::ColumnIndex() {
+  buffer = NULL;
+  hash = NULL;
+}
+
+/*
+ *
+ */
+int
+ColumnIndex::column() const {
+  hash_t* h = (hash_t*)hash;
+  if(h == NULL) return -1;
+  return h->column;
+}
+
+/*
+ *
+ */
+unsigned int
+ColumnIndex::count(const string_view& key) const {
+  int rank;
+  unsigned int n = 0;
+  TableBuffer* tb = (TableBuffer*)buffer;
+  hash_t* h = (hash_t*)hash;
+  if(h == NULL) return 0;
+
+  /* Follow the chain past each match. */
+  rank = tb->lookup(h, key.data(), key.size());
+  while(rank >= 0) {
+    n++;
+    rank = h->chain[rank];
+    for(; rank >= 0; rank = h->chain[rank]) {
+      row_t* row = (tb->rows + tb->rank2locus[rank]);
+      field_t* f = (row->fields + h->column);
+      if(f->length != key.size()) continue;
+      if(memcmp((row->line + f->offset), key.data(), key.size()) == 0) break;
+    }
+  }
+  return n;
+}
+
+/*
+ *
+ */
+int
+ColumnIndex::find(const string_view& key) const {
+  int rank;
+  TableBuffer* tb = (TableBuffer*)buffer;
+  hash_t* h = (hash_t*)hash;
+  if(h == NULL) return -1;
+  if((rank = tb->lookup(h, key.data(), key.size())) < 0) return -1;
+  return tb->rank2locus[rank];
+}
+
+/*
+ *
+ */
+ColumnIndexObject::ColumnIndexObject(void* tb, void* h) {
+  buffer = tb;
+  hash = h;
+}
@@ -53,9 +53,12 @@ ConfigTable::ConfigTable(const ConfigTable& ct) {
 }
 
 /*
- *
+ * The file is parsed once into a dictionary of instructions. Each
+ * entry lists the matching rows in sorted order together with their
+ * numeric values.
  */
 ConfigTable::ConfigTable(const std::string& s, const char c) {
+  int i, j;
   TableBuffer* tb = (TableBuffer*)buffer;
   if(tb != NULL) delete tb;
   ConfigTable* t = (ConfigTable*)(new Table(s, c));
@@ -63,6 +66,21 @@ ConfigTable::ConfigTable(const std::string& s, const char c) {
   t->buffer = new TableBuffer(0);
   delete t;
   this->sort();
+
+  /* Collect instructions. */
+  tb = (TableBuffer*)buffer;
+  tb->dictionary = new dictionary_t();
+  for(i = 0; i < tb->n_rows; i++) {
+    Row r = (*this).Table::operator[](i);
+    if(r.size() < 1) continue;
+    entry_t& e = (*(tb->dictionary))[r[0]];
+    if(e.rows.size() < 1) e.top = 0;
+    else if(r.rank() > e.rows[e.top].rank()) e.top = e.rows.size();
+    e.numbers.push_back(vector<double>(r.size()));
+    for(j = 0; j < (int)(r.size()); j++)
+      e.numbers.back()[j] = r.number(j);
+    e.rows.push_back(r);
+  }
 }
 
 /*
@@ -70,32 +88,12 @@ ConfigTable::ConfigTable(const std::string& s, const char c) {
  */
 Row
 ConfigTable::operator[](const string& attr) const {
-  int i, n;
-  int index = -1;
-  int rank = -1;
-  vector<int> indices;
-  vector<int> columns;
-  vector<string> keywords;
-  Table* t = (Table*)this;
-  Row r;
-
-  /* Find relevant rows. */
-  if(t->size() < 1) return r;
-  columns.push_back(0);
-  keywords.push_back(attr);
-  indices = t->find(keywords, columns);
-  
-  /* Find row with largest rank in the original data. */
-  n = indices.size();
-  for(i = 0; i < n; i++) {
-    r = (*t)[indices[i]];
-    if(r.rank() > rank) {
-      rank = r.rank();
-      index = indices[i];
-    }
-  }
-
-  return (*t)[index];
+  dictionary_t::const_iterator pos;
+  TableBuffer* tb = (TableBuffer*)buffer;
+  if(tb->dictionary == NULL) return Row();
+  if((pos = tb->dictionary->find(attr)) == tb->dictionary->end())
+    return Row();
+  return (pos->second).rows[(pos->second).top];
 }
 
 /*
@@ -103,27 +101,41 @@ ConfigTable::operator[](const string& attr) const {
  */
 Row
 ConfigTable::get(const string& attr, const int i) const {
-  int n;
-  int index = -1;
-  vector<int> indices;
-  vector<int> columns;
-  vector<string> keywords;
-  Table* t = (Table*)this;
-  Row r;
-
-  /* Find relevant rows. */
-  if(t->size() < 1) return r;
-  columns.push_back(0);
-  keywords.push_back(attr);
-  indices = t->find(keywords, columns);
-
-  /* Find row with the given index. */
-  index = -1;
-  n = indices.size();
-  if((i >= 0) && (i < n))
-    index = indices[i];
-
-  return (*t)[index];
+  dictionary_t::const_iterator pos;
+  TableBuffer* tb = (TableBuffer*)buffer;
+  if(tb->dictionary == NULL) return Row();
+  if((pos = tb->dictionary->find(attr)) == tb->dictionary->end())
+    return Row();
+  if((i < 0) || (i >= (int)((pos->second).rows.size()))) return Row();
+  return (pos->second).rows[i];
+}
+
+/*
+ *
+ */
+unsigned int
+ConfigTable::count(const string& attr) const {
+  dictionary_t::const_iterator pos;
+  TableBuffer* tb = (TableBuffer*)buffer;
+  if(tb->dictionary == NULL) return 0;
+  if((pos = tb->dictionary->find(attr)) == tb->dictionary->end())
+    return 0;
+  return (pos->second).rows.size();
+}
+
+/*
+ *
+ */
+double
+ConfigTable::number(const string& attr, const int j) const {
+  dictionary_t::const_iterator pos;
+  TableBuffer* tb = (TableBuffer*)buffer;
+  if(tb->dictionary == NULL) return Row::nan();
+  if((pos = tb->dictionary->find(attr)) == tb->dictionary->end())
+    return Row::nan();
+  const vector<double>& values = (pos->second).numbers[(pos->second).top];
+  if((j < 0) || (j >= (int)(values.size()))) return Row::nan();
+  return values[j];
 }
 
 /*
@@ -40,24 +40,48 @@
 
 namespace cranefoot {
 
+  /*
+   * Process-wide table of interned names. Each distinct string is stored
+   * once and identified by a 32-bit id, so that names can be compared and
+   * hashed as integers. The empty string always has id 0. The table is
+   * safe to use from multiple threads.
+   */
+  class Name {
+  public:
+
+    /* Id that no string maps to. */
+    static const unsigned int invalid = 0xffffffff;
+
+    /* Return the id of the argument, or invalid if the string is not in
+       the table. The table is not modified. */
+    static unsigned int find(const std::string&);
+
+    /* Return the id of the argument. New strings are added to the table. */
+    static unsigned int intern(const std::string&);
+
+    /* Return the string that corresponds to an id. Unknown ids map to the
+       empty string. */
+    static const std::string& text(const unsigned int);
+  };
+
   /*
    * Pedigree record. Each individual must have exactly one vertex.
    */
   struct Vertex {
 
-    /* Unique name for each vertex. */
-    std::string name;
+    /* Unique name for each vertex (interned, see Name). */
+    unsigned int name;
 
     /* Unique name for each family (i.e. distinct set of vertices). */
     std::string family_name;
 
     /* Name of the father vertex. If no such vertex exists, father is
        considered missing. */
-    std::string father;
+    unsigned int father;
 
     /* Name of the mother vertex. If no such vertex exists, mother is
        considered missing. */
-    std::string mother;
+    unsigned int mother;
 
     /* Node ordering in the family graph. The order of siblings is determined
        by age so that those with high age are given small x-coordinates. */
@@ -74,6 +98,78 @@ namespace cranefoot {
     float up_attach;
   };
 
+  /*
+   * Annealing schedule for the family layout.
+   */
+  enum ScheduleMode {
+
+    /* Temperature follows the time limit, or decays at a fixed rate if
+       a random seed is given. */
+    TIME_SCHEDULE,
+
+    /* Temperature decays over a fixed number of iterations. */
+    ITERATION_SCHEDULE,
+
+    /* Temperature decays at a fixed rate, but annealing stops early when
+       the lowest layout cost improves by less than a relative epsilon over
+       a window of iterations. Checks start once the temperature has
+       dropped to half of its initial value. */
+    CONVERGENCE_SCHEDULE
+  };
+
+  struct Schedule {
+
+    /* Schedule type. */
+    ScheduleMode mode;
+
+    /* Number of iterations for ITERATION_SCHEDULE, or the upper limit
+       for CONVERGENCE_SCHEDULE (ignored if zero). */
+    unsigned int iterations;
+
+    /* Relative cost improvement below which CONVERGENCE_SCHEDULE
+       stops. */
+    float epsilon;
+
+    /* Number of iterations between cost evaluations (100 if zero). */
+    unsigned int window;
+
+    /* Range of repulsion between branches. If positive, only pairs of
+       branches closer than this are evaluated, and they are found with a
+       spatial grid. If zero, all pairs are evaluated exactly. */
+    float repulsion;
+
+    /* Number of independent annealing chains with different random
+       starts. Each chain gets the full schedule and the layout with the
+       lowest cost is kept (one chain if zero). */
+    unsigned int chains;
+
+    /* Maximum number of threads that run chains at the same time (one
+       thread if zero). */
+    unsigned int threads;
+  };
+
+  /*
+   * Layout quality. Smaller values are better.
+   */
+  struct Cost {
+
+    /* Area of the bounding box. */
+    float area;
+
+    /* Ratio of the longer side of the bounding box to the shorter. */
+    float aspect;
+
+    /* Total length of the bonds between branches. */
+    float length;
+
+    /* Total area where branch frames, including the repulsion field
+       around them, overlap. */
+    float overlap;
+
+    /* Combined score: area*aspect + length + 100*overlap. */
+    float total;
+  };
+
   /*
    * Family graph record that represent a mating unit. An individual can be
    * present in multiple nodes.
@@ -102,9 +198,10 @@ namespace cranefoot {
     float x_b;
     float y;
 
-    /* Names of the individuals. */
-    std::string alpha;
-    std::string beta;
+    /* Names of the individuals (interned, see Name). If the node has
+       only one individual, beta is 0. */
+    unsigned int alpha;
+    unsigned int beta;
 
     /* Children of the mating unit, indicated by node indices. */
     std::vector<int> children;
@@ -126,9 +223,13 @@ namespace cranefoot {
     /* Create empty family. */
     Family();
 
-    /* Copy constructor. Creates a full duplicate. */
+    /* Copy constructor. The family data is shared between the two objects
+       until either of them is modified, so copying takes constant time. */
     Family(const Family&);
 
+    /* Move constructor. The argument is left empty. */
+    Family(Family&&);
+
     /* Create a new family object from a list of pedigree records. The
        topology is determined by child-parent links. */
     Family(const std::vector<Vertex>&);
@@ -137,9 +238,13 @@ namespace cranefoot {
     ~Family();
 
     /* Copy contents of the argument to the calling object.
-       The old contents are discarded. */
+       The old contents are discarded. Data is shared as in the copy
+       constructor. */
     void operator=(const Family&);
 
+    /* Swap the contents of the argument and the calling object. */
+    void operator=(Family&&);
+
     /* List of topological errors. */
     std::vector<std::string> errors();
 
@@ -147,6 +252,9 @@ namespace cranefoot {
        might change when the layout is changed by additional simulations. */
     float height();
 
+    /* Score the current layout. */
+    Cost cost();
+
     /* Check if family is non-empty and topologically correct. */
     bool is_consistent();
 
@@ -163,6 +271,12 @@ namespace cranefoot {
        indicates whether runtime messages should be printed on the screen.*/
     unsigned int simulate(const float, const int, const bool);
 
+    /* Apply simulated annealing with the specified schedule. The time
+       limit is only used by TIME_SCHEDULE. Returns the number of
+       iterations used. */
+    unsigned int simulate(const float, const int, const bool,
+			  const Schedule&);
+
     /* Number of family members. */
     unsigned int size();
 
@@ -174,6 +288,10 @@ namespace cranefoot {
        one family object is created. */
     static std::map<std::string, Family> create(const std::vector<Vertex>&);
 
+    /* Set the number of worker threads used to create families. If zero,
+       the number of hardware threads is used. */
+    static void threads(const unsigned int);
+
     /* Version identification. */
     static std::string version();
   };
@@ -36,33 +36,60 @@
 using namespace std;
 using namespace cranefoot;
 
-class CompareFamily {
-private:
-  vector<Vertex>* g;
-public:
-  CompareFamily(const vector<Vertex>* v) {
-    g = (vector<Vertex>*)v;
-  };
-  bool operator()(const int i1, const int i2) const {
-    Vertex& mb1 = (*g)[i1];
-    Vertex& mb2 = (*g)[i2];
-    if(mb1.family_name < mb2.family_name) return true;
-    return false;
-  };
-};
+static atomic<unsigned int> Threads(0);
+
+/*
+ * Family handles share a reference-counted FamilyObject. Copies only
+ * increment the count, and a handle that is about to modify the layout
+ * detaches itself with a private duplicate first.
+ */
+static FamilyObject*
+share(FamilyObject* fo) {
+  (fo->f_refs)++;
+  return fo;
+}
+
+static void
+release(FamilyObject* fo) {
+  if(fo == NULL) return;
+  if(--(fo->f_refs) == 0) delete fo;
+}
+
+static FamilyObject*
+detach(void** buffer) {
+  FamilyObject* fo = (FamilyObject*)(*buffer);
+  if(fo->f_refs < 2) return fo;
+  *buffer = new FamilyObject(fo);
+  release(fo);
+  return (FamilyObject*)(*buffer);
+}
+
+static FamilyObject*
+empty_family() {
+  static FamilyObject* fo = new FamilyObject();
+  return share(fo);
+}
 
 /*
  *
  */
 Family::Family() {
-  buffer = new FamilyObject();
+  buffer = empty_family();
 }
 
 /*
  *
  */
 Family::Family(const Family& fam) {
-  buffer = new FamilyObject((FamilyObject*)(fam.buffer));
+  buffer = share((FamilyObject*)(fam.buffer));
+}
+
+/*
+ *
+ */
+Family::Family(Family&& fam) {
+  buffer = fam.buffer;
+  fam.buffer = empty_family();
 }
 
 /*
@@ -72,6 +99,7 @@ Family::Family(const vector<Vertex>& graph) {
   FamilyObject* fo = new FamilyObject(graph);
   fo->link(true);
   fo->branch();
+  fo->report();
   buffer = fo;
 }
 
@@ -79,8 +107,7 @@ Family::Family(const vector<Vertex>& graph) {
  *
  */
 Family::~Family() {
-  FamilyObject* fo = (FamilyObject*)buffer;
-  delete fo;
+  release((FamilyObject*)buffer);
 }
 
 /*
@@ -89,8 +116,27 @@ Family::~Family() {
 void
 Family::operator=(const Family& fam) {
   FamilyObject* fo = (FamilyObject*)buffer;
-  delete fo;
-  buffer = new FamilyObject((FamilyObject*)(fam.buffer));
+  buffer = share((FamilyObject*)(fam.buffer));
+  release(fo);
+}
+
+/*
+ *
+ */
+void
+Family::operator=(Family&& fam) {
+  void* ptr = buffer;
+  buffer = fam.buffer;
+  fam.buffer = ptr;
+}
+
+/*
+ *
+ */
+Cost
+Family::cost() {
+  FamilyObject* fo = (FamilyObject*)buffer;
+  return fo->cost();
 }
 
 /*
@@ -143,8 +189,25 @@ Family::nodes() {
  */
 unsigned int
 Family::simulate(const float limit, const int seed, const bool flag) {
-  FamilyObject* fo = (FamilyObject*)buffer;
-  return fo->simulate(limit, seed, flag);
+  Schedule schedule;
+  schedule.mode = TIME_SCHEDULE;
+  schedule.iterations = 0;
+  schedule.epsilon = 0.0;
+  schedule.window = 0;
+  schedule.repulsion = 0.0;
+  schedule.chains = 1;
+  schedule.threads = 1;
+  return simulate(limit, seed, flag, schedule);
+}
+
+/*
+ *
+ */
+unsigned int
+Family::simulate(const float limit, const int seed, const bool flag,
+		 const Schedule& schedule) {
+  FamilyObject* fo = detach(&buffer);
+  return fo->simulate(limit, seed, flag, schedule);
 }
 
 /*
@@ -171,38 +234,92 @@ Family::width() {
 map<string, Family>
 Family::create(const std::vector<Vertex>& graph) {
   unsigned int i, k;
-  string family_name = "";
-  vector<int> view;
-  vector<Vertex> subgraph;
+  vector<int> group(graph.size(), -1);
+  vector<int> first;
+  vector<unsigned int> offsets;
+  unordered_map<string_view, int> name2group;
+  unordered_map<string_view, int>::iterator pos;
   map<string, Family> families;
   if(graph.size() < 1) return families;
 
-  /* Create a sorted view. */
+  /* Assign records to families by family name. The names are viewed in
+     place and kept apart from the interned individual names. */
   for(i = 0; i < graph.size(); i++) {
-    if(graph[i].name == "") continue;
+    if(graph[i].name == 0) continue;
     if(graph[i].family_name == "") continue;
-    view.push_back(i);
+    string_view s(graph[i].family_name);
+    if((pos = name2group.find(s)) == name2group.end()) {
+      pos = name2group.insert(make_pair(s, (int)(first.size()))).first;
+      first.push_back(i);
+      offsets.push_back(0);
+    }
+    group[i] = pos->second;
+    offsets[group[i]]++;
+  }
+
+  /* Partition record indices so that each family is a contiguous
+     span in input order. */
+  unsigned int total = 0;
+  for(k = 0; k < offsets.size(); k++) {
+    unsigned int n = offsets[k];
+    offsets[k] = total;
+    total += n;
+  }
+  offsets.push_back(total);
+  vector<int> rows(total);
+  vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+  for(i = 0; i < graph.size(); i++) {
+    if(group[i] < 0) continue;
+    rows[fill[group[i]]++] = i;
   }
-  sort(view.begin(), view.end(), CompareFamily(&graph));
   
-  /* Create families. */
-  for(i = 0; i < view.size(); i++) {
-    k = view[i];
-    if((graph[k].name).length() < 1) continue;
-    if(family_name.length() < 1) family_name = graph[k].family_name;
-    if(family_name != graph[k].family_name) {
-      families[family_name] = Family(subgraph);
-      subgraph.clear();
-      family_name = graph[k].family_name;
+  /* Create families on a pool of worker threads. */
+  unsigned int n_families = first.size();
+  unsigned int n_threads = Threads;
+  vector<FamilyObject*> objects(n_families, NULL);
+  atomic<unsigned int> next(0);
+  vector<thread> workers;
+  auto work = [&]() {
+    unsigned int j;
+    while((j = next++) < n_families) {
+      unsigned int n = (offsets[j + 1] - offsets[j]);
+      FamilyObject* fo = new FamilyObject(graph, &(rows[offsets[j]]), n);
+      fo->link(true);
+      fo->branch();
+      objects[j] = fo;
     }
-    subgraph.push_back(graph[k]);
+  };
+  if(n_threads < 1) n_threads = thread::hardware_concurrency();
+  if(n_threads > n_families) n_threads = n_families;
+  if(n_threads < 2) work();
+  else {
+    for(k = 0; k < n_threads; k++)
+      workers.push_back(thread(work));
+    for(k = 0; k < n_threads; k++)
+      workers[k].join();
+  }
+  
+  /* Collect families and print diagnostics in family order. */
+  for(k = 0; k < n_families; k++) {
+    Family& fam = families[graph[first[k]].family_name];
+    release((FamilyObject*)(fam.buffer));
+    fam.buffer = objects[k];
   }
-  if(subgraph.size() > 0)
-    families[family_name] = Family(subgraph);
+  map<string, Family>::iterator fpos;
+  for(fpos = families.begin(); fpos != families.end(); fpos++)
+    ((FamilyObject*)((fpos->second).buffer))->report();
 
   return families;
 }
 
+/*
+ *
+ */
+void
+Family::threads(const unsigned int n) {
+  Threads = n;
+}
+
 /*
  *
  */
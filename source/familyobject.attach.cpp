@@ -0,0 +1,70 @@
+/* file: familyobject.attach.cpp
+  Copyright (C) 2008 Ville-Petteri Makinen
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the
+  Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+  CITATION (if not provided by software website)
+    Makinen V-P, software name, URL:http://www.iki.fi/~vpmakine/
+
+  CONTACT (if not provided by citation)
+    Ville-Petteri Makinen
+ 
+    Folkhalsan Research Center
+    Biomedicum Helsinki P.O.Box 63
+    Haartmaninkatu 8 00014, Helsinki, Finland
+    Tel: +358 9 191 25462
+    Fax: +358 9 191 25452
+
+    WWW:   http://www.iki.fi/~vpmakine
+*/
+
+#include "familyobject.h"
+
+/*
+ * Collect the bonds between branches into a compressed row list: the
+ * attachments of branch i are at anchors[i]...anchors[i + 1] - 1. The
+ * order is that of the branch bondings and the member bonds. Must be
+ * called after the branches are connected and walked.
+ */
+void
+FamilyObject::attach() {
+  unsigned int i, j, k;
+  unsigned int n = branches.size();
+  anchors.assign(n + 1, 0);
+  attachments.clear();
+  for(i = 0; i < n; i++) {
+    vector<int>& bondings = branches[i].bondings;
+    for(j = 0; j < bondings.size(); j++) {
+      int ind1 = bondings[j];
+      vector<int>& bonds = members[ind1].bonds;
+      for(k = 0; k < bonds.size(); k++) {
+	int ind2 = bonds[k];
+	int tree = members[ind2].tree;
+	if(tree == members[ind1].tree) continue;
+	if(tree < 0) continue;
+	Attachment a;
+	a.branch1 = i;
+	a.branch2 = tree;
+	a.x1 = members[ind1].x;
+	a.y1 = members[ind1].y;
+	a.x2 = members[ind2].x;
+	a.y2 = members[ind2].y;
+	attachments.push_back(a);
+      }
+    }
+    anchors[i + 1] = attachments.size();
+  }
+}
@@ -40,17 +40,19 @@ bool
 FamilyObject::check(const bool sibcheck) {
   unsigned int i;
   unsigned int n_children = 0;
+  unsigned int id = 0;
   string name = "";
   vector<string> anom;
 
   /* Check that topology is correct. */
   for(i = 0; i < members.size(); i++) {
-    if(members[i].name() == name) {
+    if(members[i].name() == id) {
       fprintf(stderr, "ERROR! %s at line %d: Illegal program state.\n",
 	      __FILE__, __LINE__);
       exit(1);
     }
-    name = members[i].name();
+    id = members[i].name();
+    name = Name::text(id);
 
     /* Either 0 or 2 parents. */
     int father = members[i].father;
@@ -102,21 +104,22 @@ FamilyObject::check(const bool sibcheck) {
   if((n_children < 1) && (f_errors.size() < 1))
     error("empty\tNo offspring detected.");
   
-  /* List errors. */
+  /* List errors. The messages are collected in the family report so that
+     families checked concurrently do not interleave their output. */
   if(f_errors.size() > 0) {
-    printf("WARNING! Errors in '%s':\n", f_name.c_str());
+    f_report += ("WARNING! Errors in '" + f_name + "':\n");
     for(i = 0; i < f_errors.size(); i++)
-      printf("\t%s\n", f_errors[i].c_str());
+      f_report += ("\t" + f_errors[i] + "\n");
     return false;
   }
   if(anom.size() > 0) {
-    printf("WARNING! Anomalies in '%s':\n", f_name.c_str());
+    f_report += ("WARNING! Anomalies in '" + f_name + "':\n");
     for(i = 0; i < anom.size(); i++) {
       if(i >= 9) {
-	printf("\tRemaining anomalies suppressed.\n");
+	f_report += "\tRemaining anomalies suppressed.\n";
 	break;
       }
-      printf("\t%s\n", anom[i].c_str());
+      f_report += ("\t" + anom[i] + "\n");
     }
   }
 
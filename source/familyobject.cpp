@@ -40,6 +40,7 @@ using namespace cranefoot;
  *
  */
 FamilyObject::FamilyObject() {
+  f_refs = 1;
   f_name = "";
   f_height = 0.0;
   f_width = 0.0;
@@ -51,12 +52,16 @@ FamilyObject::FamilyObject() {
  */
 FamilyObject::FamilyObject(const FamilyObject* fo) {
   unsigned int i;
+  f_refs = 1;
   f_height = fo->f_height;
   f_width = fo->f_width;
   f_name = fo->f_name;
+  f_report = fo->f_report;
   f_errors = fo->f_errors;
   members = fo->members;
   branches = fo->branches;
+  anchors = fo->anchors;
+  attachments = fo->attachments;
   for(i = 0; i < branches.size(); i++)
     branches[i].family = this;
 }
@@ -66,64 +71,93 @@ FamilyObject::FamilyObject(const FamilyObject* fo) {
  */
 FamilyObject::FamilyObject(const vector<Vertex>& graph) {
   unsigned int i;
-  map<string, int> name2index;
+  vector<int> rows(graph.size());
+  for(i = 0; i < graph.size(); i++)
+    rows[i] = i;
+  create(graph, rows.data(), rows.size());
+}
+
+/*
+ * Create a family from a subset of the pedigree records. The records are
+ * not copied, the family reads them through the row indices.
+ */
+FamilyObject::FamilyObject(const vector<Vertex>& graph, const int* rows,
+			   const unsigned int n) {
+  create(graph, rows, n);
+}
+
+/*
+ *
+ */
+void
+FamilyObject::create(const vector<Vertex>& graph, const int* rows,
+		     const unsigned int n) {
+  unsigned int i;
+  unordered_map<unsigned int, int> name2index;
 
   /* Default values. */
+  f_refs = 1;
   f_name = "";
   f_height = 0.0;
   f_width = 0.0;
-  if(graph.size() < 1) {
+  if(n < 1) {
     f_errors.push_back("Empty family.");
     return;
   }
 
   /* Create a name mapping. */
-  f_name = graph[0].family_name;
-  for(i = 0; i < graph.size(); i++) {
-    if(graph[i].family_name != f_name) {
+  f_name = graph[rows[0]].family_name;
+  name2index.reserve(n);
+  members.reserve(n);
+  for(i = 0; i < n; i++) {
+    const Vertex& v = graph[rows[i]];
+    if(v.family_name != f_name) {
       members.clear();
       error("Multiple family names detected.");
       return;
     }
-    if((graph[i].name).length() < 1) {
+    const string& name = Name::text(v.name);
+    if(v.name == 0) {
       members.clear();
       error("Nameless individual detected.");
       return;
     }
-    if(name2index.count(graph[i].name) > 0) {
+    if(name2index.count(v.name) > 0) {
       members.clear();
-      error("Duplicate individual '" + graph[i].name + "' found.");
+      error("Duplicate individual '" + name + "' found.");
       return;
     }
-    if(graph[i].width <= 0.0) {
+    if(v.width <= 0.0) {
       members.clear();
-      error("Individual '" + graph[i].name + "' has non-positive width.");
+      error("Individual '" + name + "' has non-positive width.");
       return; 
     }
-    if(graph[i].height <= 0.0) {
+    if(v.height <= 0.0) {
       members.clear();
-      error("Individual '" + graph[i].name + "' has non-positive height.");
+      error("Individual '" + name + "' has non-positive height.");
       return; 
     }
-    if(graph[i].up_attach <= 0.0) {
+    if(v.up_attach <= 0.0) {
       members.clear();
-      error("Individual '" + graph[i].name + "' has non-positive up attach.");
+      error("Individual '" + name + "' has non-positive up attach.");
       return; 
     }
-    name2index[graph[i].name] = i;
-    members.push_back(Member(graph[i].name));
+    name2index[v.name] = i;
+    members.push_back(Member(v.name));
   }
 
   /* Find parents and set dimensions. */
-  for(i = 0; i < graph.size(); i++) {
-    if(name2index.count(graph[i].father) > 0)
-      members[i].father = name2index[graph[i].father];
-    if(name2index.count(graph[i].mother) > 0)
-      members[i].mother = name2index[graph[i].mother];
-    members[i].age = graph[i].age;
-    members[i].height = graph[i].height;
-    members[i].width = graph[i].width;
-    members[i].up_attach = graph[i].up_attach;
+  for(i = 0; i < n; i++) {
+    const Vertex& v = graph[rows[i]];
+    unordered_map<unsigned int, int>::iterator pos;
+    if((pos = name2index.find(v.father)) != name2index.end())
+      members[i].father = pos->second;
+    if((pos = name2index.find(v.mother)) != name2index.end())
+      members[i].mother = pos->second;
+    members[i].age = v.age;
+    members[i].height = v.height;
+    members[i].width = v.width;
+    members[i].up_attach = v.up_attach;
     members[i].is_original = true;
     if(members[i].up_attach > members[i].width)
       members[i].up_attach = members[i].width;
@@ -35,9 +35,13 @@
 #define familyobject_INCLUDED
 
 #include <map>
+#include <atomic>
+#include <thread>
+#include <unordered_map>
 #include <iostream>
 #include <algorithm>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <stdlib.h>
 #include <stdio.h>
@@ -45,8 +49,10 @@
 #include <math.h>
 #include "cranefoot.h"
 #include "member.h"
+#include "rng.h"
 
 #define family_VERSION "1.0.1"
+#define REPULSION_FIELD 0.5
 
 using namespace std;
 using namespace cranefoot;
@@ -64,37 +70,101 @@ public:
   FamilyObject* family;
 public:
   Branch(FamilyObject*);
-  vector<float> attract();
   void connect();
-  vector<float> repel(const Branch&);
   void update();
   void walk();
 };
 
+/*
+ * Bond from a member of the first branch to a member of the second one.
+ * The member positions are offsets inside their branches.
+ */
+struct Attachment {
+  unsigned int branch1;
+  unsigned int branch2;
+  float x1;
+  float y1;
+  float x2;
+  float y2;
+};
+
+/*
+ * Annealing state in contiguous arrays, one element per branch. The
+ * buffers are sized once per simulation and reused by every iteration.
+ */
+class Layout {
+public:
+  unsigned int size;
+  vector<float> x;
+  vector<float> y;
+  vector<float> width;
+  vector<float> height;
+  vector<float> gx;
+  vector<float> gy;
+  vector<float> fx;
+  vector<float> fy;
+  vector<float> frames;
+  vector<int> spans;
+  vector<unsigned int> cells;
+  vector<unsigned int> cursor;
+  vector<unsigned int> items;
+  float grid_origin[2];
+  float grid_cell;
+  int grid_nx;
+  FamilyObject* family;
+private:
+  void grid(const float, const float);
+  void repel_grid(const float, const float, RNG&, const float);
+  void repel_row(const unsigned int, const float, const float, RNG&);
+public:
+  Layout();
+  void attract(const unsigned int, RNG&, float*);
+  Cost cost();
+  void forces(const unsigned int);
+  void iterate(const float, RNG&, const float);
+  void load(FamilyObject*);
+  void repel(const unsigned int, const unsigned int, float*) const;
+  void store();
+  static string kernel();
+  static bool kernel(const string&);
+};
+
 class FamilyObject {
 private:
+  unsigned int anneal(Layout&, RNG&, const float, const bool, const bool,
+		      const Schedule&);
+  void attach();
   bool check(const bool);
+  void create(const vector<Vertex>&, const int*, const unsigned int);
   void error(const string&);
   void update();
 public:
+  atomic<unsigned int> f_refs;
   float f_height;
   float f_width;
   string f_name;
+  string f_report;
   vector<string> f_errors;
   vector<Member> members;
   vector<Branch> branches;
+  vector<unsigned int> anchors;
+  vector<Attachment> attachments;
 public:
   FamilyObject();
   FamilyObject(const FamilyObject*);
   FamilyObject(const vector<Vertex>&);
+  FamilyObject(const vector<Vertex>&, const int*, const unsigned int);
   unsigned int branch();
+  Cost cost();
   vector<string> errors();
   float height();
   bool is_consistent();
   unsigned int link(const bool);
   string name();
   vector<Node> nodes();
-  unsigned int simulate(const float, const int, const bool);
+  void report();
+  unsigned int simulate(const float, const int, const bool,
+			const Schedule&);
   unsigned int size();
   float width();
 };
@@ -33,53 +33,127 @@
 
 #include "familyobject.h"
 
-static void iterate(vector<Branch>&, float);
-
 /*
- *
+ * Position the branches by simulated annealing. With several chains,
+ * each chain starts from its own random positions and the layout with
+ * the lowest cost is kept. The first chain uses the same random numbers
+ * as a single chain, and the other chains have seeds derived from the
+ * family name and chain number, so the result is the same for a given
+ * seed regardless of how many threads run the chains.
  */
 unsigned int
 FamilyObject::simulate(const float limit, const int seed,
-		       const bool verbose) {
-  unsigned int i;
-  unsigned int n = 0;
-  float rho = sqrt(1.0*(members.size())*(branches.size()));
+		       const bool verbose, const Schedule& schedule) {
+  unsigned int i, k;
+  unsigned int n_chains = max(schedule.chains, 1u);
+  unsigned int n_workers = min(max(schedule.threads, 1u), n_chains);
+  bool timed = ((schedule.mode == TIME_SCHEDULE) && (seed <= 0));
   if(f_errors.size() > 0) return 0;
   if(branches.size() < 1) return 0;
-  if(limit < 1e-2) return 0;
+  if((schedule.mode == TIME_SCHEDULE) && (limit < 1e-2)) return 0;
+  if((schedule.mode == ITERATION_SCHEDULE) && (schedule.iterations < 1))
+    return 0;
   
   /* Compute node positions inside branches. */
   for(i = 0; i < branches.size(); i++) {
     branches[i].connect();
     branches[i].walk();
   }
+  attach();
+  update();
+
+  /* Chains that wait for a free thread share its time. */
+  float grace = limit;
+  if(timed) grace = limit*n_workers/n_chains;
+
+  /* Run chains. */
+  vector<RNG> rngs(n_chains);
+  vector<unsigned int> n_iter(n_chains, 0);
+  vector<Layout> layouts(n_chains);
+  for(k = 0; k < n_chains; k++) {
+    string tag = f_name;
+    if(k > 0) tag += ("#" + to_string(k));
+    rngs[k] = RNG(seed, tag);
+    layouts[k].load(this);
+  }
+  atomic<unsigned int> next(0);
+  auto work = [&]() {
+    unsigned int j;
+    while((j = next++) < n_chains)
+      n_iter[j] = anneal(layouts[j], rngs[j], grace, timed,
+			 (verbose && (n_workers < 2)), schedule);
+  };
+  if(n_workers < 2) work();
+  else {
+    vector<thread> workers;
+    for(k = 0; k < n_workers; k++)
+      workers.push_back(thread(work));
+    for(k = 0; k < n_workers; k++)
+      workers[k].join();
+  }
+
+  /* Keep the best layout, the first one if tied. */
+  unsigned int best = 0;
+  unsigned int n = n_iter[0];
+  float energy = layouts[0].cost().total;
+  for(k = 1; k < n_chains; k++) {
+    float e = layouts[k].cost().total;
+    if(e < energy) {
+      energy = e;
+      best = k;
+    }
+    n += n_iter[k];
+  }
+  layouts[best].store();
   
-  /* Initial positions. */ 
+  /* Eliminate unnecessary gaps. */
   update();
-  for(i = 0; i < branches.size(); i++) {
-    branches[i].x = rho*rand()/RAND_MAX;
-    branches[i].y = rho*rand()/RAND_MAX;
+  
+  return n;
+}
+
+/*
+ * One annealing chain from random initial positions. Returns the number
+ * of iterations.
+ */
+unsigned int
+FamilyObject::anneal(Layout& lt, RNG& rng, const float limit,
+		     const bool timed, const bool verbose,
+		     const Schedule& schedule) {
+  unsigned int i;
+  unsigned int n = 0;
+  float rho = sqrt(1.0*(members.size())*(branches.size()));
+  bool fixed = (schedule.mode == ITERATION_SCHEDULE);
+
+  /* Initial positions. */
+  for(i = 0; i < lt.size; i++) {
+    lt.x[i] = rho*rng.uniform();
+    lt.y[i] = rho*rng.uniform();
   }
   
   /* Simulation parameters. */
   unsigned int counter = 0;
+  unsigned int window = schedule.window;
   clock_t alert = clock();
   time_t start = time(NULL);
   float dt = 0.0;
   float temp0 = log(1.0 + rho);  
   float temp = temp0;
-  if(seed > 0) srand(seed);
-  else srand(start);
+  double decay = (1.0 - 1.0/(100.0 + members.size()));
+  float energy = FLT_MAX;
+  if(fixed)
+    decay = pow(0.05/temp0, 1.0/(schedule.iterations));
+  if(window < 1) window = 100;
 
   /* Simulated annealing. */
-  for(n = 0; temp > 0.05; n++) {     
+  for(n = 0; (temp > 0.05) || fixed; n++) {     
     /* Check temperature. */
     if(fabs(clock() - 1.0*alert) > CLOCKS_PER_SEC/2.0) {
       alert = clock();
       if(n%2) dt += 0.5/limit;
       else dt = difftime(time(NULL), start)/limit;
       float r = exp(10*(dt - 0.6));
-      if(seed <= 0) {
+      if(timed) {
 	temp = (1.0 - r/(1.0 + r))*temp0;
 	if((dt > 0.95) && (temp > 0.05)) temp = 0.05;
       }  
@@ -95,7 +169,7 @@ FamilyObject::simulate(const float limit, const int seed,
 	if(counter%2 == 0) {
 	  printf("\t%s\t", f_name.c_str());
 	  printf("%d\t", n);
-	  if(seed <= 0) printf("%3.0f%%\t", 100.0*dt);
+	  if(timed) printf("%3.0f%%\t", 100.0*dt);
 	  printf("%.2f ", temp);
 	  fflush(stdout);
 	}
@@ -104,83 +178,25 @@ FamilyObject::simulate(const float limit, const int seed,
     }
 
     /* Update configuration. */
-    iterate(branches, temp);
-    temp *= (1.0 - 1.0/(100.0 + members.size()));
-  }
-  if(verbose) printf("\r%80s\r", "");
-  
-  /* Eliminate unnecessary gaps. */
-  update();
-  
-  return n;
-}
-
-/*
- *
- */
-static void
-iterate(vector<Branch>& branches, float temp) {
-  unsigned int i, j;
-  unsigned int n = branches.size();
-  float x, y, r;
-  float box[4] = {FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX};
-  vector<float> gx(n, 0.0);
-  vector<float> gy(n, 0.0);
-  vector<float> f;
-  if(n < 2) return;  
-
-  /* Determine geometric cost. */
-  for(i = 0; i < n; i++) {
-    x = branches[i].x;
-    y = branches[i].y;
-    if(x < box[0]) box[0] = x;
-    if(y < box[1]) box[1] = y;
-    x += branches[i].width;
-    y += branches[i].height;
-    if(x > box[2]) box[2] = x;
-    if(y > box[3]) box[3] = y;
-  }
-  x = pow((box[2] - box[0]), 2);  
-  y = pow((box[3] - box[1]), 2);  
-  r = 0.5*(x + y + 1e-6);
-  x /= r;
-  y /= r;
-
-  /* Compute gradients. */
-  for(i = 0; i < n; i++) {
-    for(j = (i + 1); j < n; j++) {
-	f = branches[i].repel(branches[j]);
-	gx[i] += (y + 0.2*rand()/RAND_MAX)*f[0];
-	gy[i] += (x + 0.2*rand()/RAND_MAX)*f[1];
-	gx[j] -= (y + 0.2*rand()/RAND_MAX)*f[0];
-	gy[j] -= (x + 0.2*rand()/RAND_MAX)*f[1];
+    lt.iterate(temp, rng, schedule.repulsion);
+    temp *= decay;
+
+    /* Check iteration limits and convergence. */
+    if(schedule.mode == TIME_SCHEDULE) continue;
+    if((schedule.iterations > 0) && (n + 1) >= schedule.iterations) {
+      n++;
+      break;
     }
-    f = branches[i].attract();
-    gx[i] += (0.8 + 0.2*rand()/RAND_MAX)*f[0];
-    gy[i] += (0.8 + 0.2*rand()/RAND_MAX)*f[1];
-  }
-
-  /* Central attractor. */
-  float w = 0.5*(box[2] - box[0] + 1e-6);
-  float h = 0.5*(box[3] - box[1] + 1e-6);
-  float x0 = 0.5*(box[2] + box[0]);
-  float y0 = 0.5*(box[3] + box[1]);
-  r = sqrt(w*w + h*h);
-  for(i = 0; i < n; i++) {
-    x = (x0 - branches[i].x - 0.5*(branches[i].width))/r;
-    y = (y0 - branches[i].y - 0.5*(branches[i].height))/r;
-    gx[i] += x;
-    gy[i] += y;
-  }
-
-  /* Update positions. */
-  for(i = 0; i < n; i++) {
-    r = sqrt(gx[i]*gx[i] + gy[i]*gy[i]);
-    if(r > temp) {
-      gx[i] *= temp/r;
-      gy[i] *= temp/r;
+    if(schedule.mode != CONVERGENCE_SCHEDULE) continue;
+    if((n + 1)%window != 0) continue;
+    if(temp > 0.5*temp0) continue;
+    float e = lt.cost().total;
+    if((energy - e) < (schedule.epsilon)*fabs(energy)) {
+      n++;
+      break;
     }
-    branches[i].x += (gx[i] - box[0]);
-    branches[i].y += (gy[i] - box[1]);
+    energy = min(energy, e);
   }
+  if(verbose) printf("\r%80s\r", "");
+  return n;
 }
@@ -33,6 +33,17 @@
 
 #include "familyobject.h"
 
+/*
+ * Score the current branch positions. A temporary layout is used, so
+ * that a family shared by several handles is not modified.
+ */
+Cost
+FamilyObject::cost() {
+  Layout lt;
+  lt.load(this);
+  return lt.cost();
+}
+
 /*
  *
  */
@@ -109,7 +120,7 @@ FamilyObject::nodes() {
     node.x_b = node.x_a;
     node.y = (branches[tree].y + members[i].y + height);
     node.alpha = members[i].name();
-    node.beta = "";
+    node.beta = 0;
     node.children = vector<int>(0);
     node.links = vector<int>(0);
 
@@ -143,7 +154,8 @@ FamilyObject::nodes() {
   }
 
   /* Collect original nodes. */
-  map<string, int> name2index;
+  unordered_map<unsigned int, int> name2index;
+  unordered_map<unsigned int, int>::iterator pos;
   for(i = 0; i < graph.size(); i++) {
     if(graph[i].origin_a == false) continue;
     name2index[graph[i].alpha] = i;
@@ -151,15 +163,15 @@ FamilyObject::nodes() {
   
   /* Connect duplicates to originals. */
   for(i = 0; i < graph.size(); i++) {
-    string& alpha = graph[i].alpha; 
-    string& beta = graph[i].beta;
-    if(name2index.count(alpha) > 0) {
-      if((k = name2index[alpha]) != i)
+    unsigned int alpha = graph[i].alpha; 
+    unsigned int beta = graph[i].beta;
+    if((pos = name2index.find(alpha)) != name2index.end()) {
+      if((k = pos->second) != i)
 	(graph[k].links).push_back(i);
     }
-    if(beta.length() < 1) continue;
-    if(name2index.count(beta) > 0) {
-      if((k = name2index[beta]) != i)
+    if(beta == 0) continue;
+    if((pos = name2index.find(beta)) != name2index.end()) {
+      if((k = pos->second) != i)
 	(graph[k].links).push_back(i);
     }
     else {
@@ -171,6 +183,16 @@ FamilyObject::nodes() {
   return graph;
 }
 
+/*
+ * Print and clear the diagnostics collected by check().
+ */
+void
+FamilyObject::report() {
+  if(f_report.length() < 1) return;
+  printf("%s", f_report.c_str());
+  f_report.clear();
+}
+
 /*
  *
  */
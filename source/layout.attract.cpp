@@ -1,4 +1,4 @@
-/* file: branch.attract.cpp
+/* file: layout.attract.cpp
   Copyright (C) 2008 Ville-Petteri Makinen
 
   This program is free software; you can redistribute it and/or
@@ -33,63 +33,56 @@
 
 #include "familyobject.h"
 
-static void gforce(vector<float>&, float, float, float, float);
-static void rforce(vector<float>&, float, float, float, float);
+static void gforce(float*, float, float, float, float);
+static void rforce(float*, float, float, float, float);
 
 /*
- *
+ * Attraction of a branch towards the branches it has bonds with. The
+ * gradient is written to g.
  */
-vector<float>
-Branch::attract() {
-  unsigned int i, k, n;
-  int ind1, ind2;
-  vector<Member>& members = family->members;
-  vector<Branch>& branches = family->branches;
-  vector<float> g(2, 0.0);
+void
+Layout::attract(const unsigned int ind, RNG& rng, float* g) {
+  unsigned int k, n;
+  int ind1;
+  Branch& branch = family->branches[ind];
+  const Attachment* list = (family->attachments).data();
+  unsigned int first = family->anchors[ind];
+  unsigned int last = family->anchors[ind + 1];
 
-  if(vertices.size() == 0) {
+  g[0] = 0.0;
+  g[1] = 0.0;
+  if((branch.vertices).size() == 0) {
     fprintf(stderr, "ERROR! %s at line %d: ", __FILE__, __LINE__);
     fprintf(stderr, "Illegal program state.\n");
     exit(1);
   }
-  if(branches.size() < 1) return g;
+  if(size < 1) return;
 
   /* Connections with other branches. */
-  n = 0;
-  for(i = 0; i < bondings.size(); i++) {
-    ind1 = bondings[i];
-    vector<int>& bonds = members[ind1].bonds;
-    for(k = 0; k < bonds.size(); k++) {
-      ind2 = bonds[k];
-      if(members[ind2].tree == members[ind1].tree) continue;
-      if(members[ind2].tree < 0) continue;
-      Branch& b2 = branches[members[ind2].tree];
-      gforce(g, (x + members[ind1].x), (y + members[ind1].y),
-	     (b2.x + members[ind2].x), (b2.y + members[ind2].y));
-      n++;
-    }
+  for(k = first; k < last; k++) {
+    const Attachment& a = list[k];
+    gforce(g, (x[ind] + a.x1), (y[ind] + a.y1),
+	   (x[a.branch2] + a.x2), (y[a.branch2] + a.y2));
   }
+  n = (last - first);
 
   /* Normalize gradient. */
   g[0] /= (1.0 + n);
   g[1] /= (1.0 + n);
   
   /* Create random connection to ensure that branches stay together.*/
-  if(1.0*rand()/RAND_MAX*n < 1.0) {
-    ind1 = (rand())%(branches.size());
-    Branch& b = branches[ind1];
-    rforce(g, (x + 0.5*width), (y + 0.5*height),
-	   (b.x + 0.5*(b.width)), (b.y + 0.5*(b.height)));
+  if(rng.uniform()*n < 1.0) {
+    ind1 = rng.next()%size;
+    rforce(g, (x[ind] + 0.5*width[ind]), (y[ind] + 0.5*height[ind]),
+	   (x[ind1] + 0.5*(width[ind1])), (y[ind1] + 0.5*(height[ind1])));
   }
-  
-  return g;
 }
 
 /*
  *
  */
 static void
-gforce(vector<float>& g, float x1, float y1, float x2, float y2) {
+gforce(float* g, float x1, float y1, float x2, float y2) {
   float dx = (x2 - x1);
   float dy = (y2 - y1);
   float r = sqrt(dx*dx + dy*dy);
@@ -104,7 +97,7 @@ gforce(vector<float>& g, float x1, float y1, float x2, float y2) {
  *
  */
 static void
-rforce(vector<float>& g, float x1, float y1, float x2, float y2) {
+rforce(float* g, float x1, float y1, float x2, float y2) {
   float dx = (x2 - x1);
   float dy = (y2 - y1);
   float r = sqrt(dx*dx + dy*dy);
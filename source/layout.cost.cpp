@@ -0,0 +1,116 @@
+/* file: layout.cost.cpp
+  Copyright (C) 2008 Ville-Petteri Makinen
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the
+  Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+  CITATION (if not provided by software website)
+    Makinen V-P, software name, URL:http://www.iki.fi/~vpmakine/
+
+  CONTACT (if not provided by citation)
+    Ville-Petteri Makinen
+ 
+    Folkhalsan Research Center
+    Biomedicum Helsinki P.O.Box 63
+    Haartmaninkatu 8 00014, Helsinki, Finland
+    Tel: +358 9 191 25462
+    Fax: +358 9 191 25452
+
+    WWW:   http://www.iki.fi/~vpmakine
+*/
+
+#include "familyobject.h"
+
+#define OVERLAP_PENALTY 100.0
+
+/*
+ * Score the layout by the bounding box, the bonds between branches and
+ * the overlap of the branch frames. The frames are padded by the same
+ * repulsion field that Layout::repel() uses. Overlapping frames make the
+ * drawing unreadable, so overlap is weighted heavily. Drives the
+ * convergence schedule and the choice between annealing chains.
+ *
+ * Overlapping pairs are found with the grid of repel_grid(), which is
+ * rebuilt here, so that scoring a large family does not visit every pair.
+ */
+Cost
+Layout::cost() {
+  unsigned int i, j, k, a, b, m;
+  int cx, cy;
+  float xp, yp, dx, dy;
+  float box[4] = {FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX};
+  unsigned int n = size;
+  Cost c;
+  c.area = 0.0;
+  c.aspect = 1.0;
+  c.length = 0.0;
+  c.overlap = 0.0;
+  c.total = 0.0;
+  if(n < 1) return c;
+
+  /* Bounding box. */
+  for(i = 0; i < n; i++) {
+    xp = x[i];
+    yp = y[i];
+    if(xp < box[0]) box[0] = xp;
+    if(yp < box[1]) box[1] = yp;
+    xp += width[i];
+    yp += height[i];
+    if(xp > box[2]) box[2] = xp;
+    if(yp > box[3]) box[3] = yp;
+  }
+  xp = (box[2] - box[0]);
+  yp = (box[3] - box[1]);
+  c.area = xp*yp;
+  if((xp > 0.0) && (yp > 0.0)) c.aspect = max(xp/yp, yp/xp);
+
+  /* Bonds between branches, each counted once. */
+  vector<Attachment>& attachments = family->attachments;
+  for(k = 0; k < attachments.size(); k++) {
+    const Attachment& a = attachments[k];
+    if(a.branch2 < a.branch1) continue;
+    dx = (x[a.branch2] + a.x2 - x[a.branch1] - a.x1);
+    dy = (y[a.branch2] + a.y2 - y[a.branch1] - a.y1);
+    c.length += sqrt(dx*dx + dy*dy);
+  }
+
+  /* Overlapping frames. Each pair is evaluated in the cell that holds
+     the lower corner of the intersection of the padded frames. */
+  grid(REPULSION_FIELD, 0.0);
+  unsigned int n_cells = (cells.size() - 1);
+  for(m = 0; m < n_cells; m++) {
+    for(a = cells[m]; a < cells[m + 1]; a++) {
+      i = items[a];
+      float* p = &(frames[4*i]);
+      for(b = (a + 1); b < cells[m + 1]; b++) {
+	j = items[b];
+	float* q = &(frames[4*j]);
+	if((p[0] > q[2]) || (q[0] > p[2])) continue;
+	if((p[1] > q[3]) || (q[1] > p[3])) continue;
+	cx = (int)((max(p[0], q[0]) - grid_origin[0])/grid_cell);
+	cy = (int)((max(p[1], q[1]) - grid_origin[1])/grid_cell);
+	if((unsigned int)(cy*grid_nx + cx) != m) continue;
+	dx = min(x[i] + width[i], x[j] + width[j]) - max(x[i], x[j]);
+	dy = min(y[i] + height[i], y[j] + height[j]) - max(y[i], y[j]);
+	dx += 2*REPULSION_FIELD;
+	dy += 2*REPULSION_FIELD;
+	if((dx > 0.0) && (dy > 0.0)) c.overlap += dx*dy;
+      }
+    }
+  }
+
+  c.total = (c.area*(c.aspect) + c.length + OVERLAP_PENALTY*(c.overlap));
+  return c;
+}
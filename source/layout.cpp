@@ -0,0 +1,87 @@
+/* file: layout.cpp
+  Copyright (C) 2008 Ville-Petteri Makinen
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the
+  Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+  CITATION (if not provided by software website)
+    Makinen V-P, software name, URL:http://www.iki.fi/~vpmakine/
+
+  CONTACT (if not provided by citation)
+    Ville-Petteri Makinen
+ 
+    Folkhalsan Research Center
+    Biomedicum Helsinki P.O.Box 63
+    Haartmaninkatu 8 00014, Helsinki, Finland
+    Tel: +358 9 191 25462
+    Fax: +358 9 191 25452
+
+    WWW:   http://www.iki.fi/~vpmakine
+*/
+
+#include "familyobject.h"
+
+/*
+ *
+ */
+Layout::Layout() {
+  size = 0;
+  grid_origin[0] = 0.0;
+  grid_origin[1] = 0.0;
+  grid_cell = 1.0;
+  grid_nx = 1;
+  family = NULL;
+}
+
+/*
+ * Copy branch positions and sizes into the arrays. Buffers only grow,
+ * so repeated simulations of the same family do not reallocate.
+ */
+void
+Layout::load(FamilyObject* fo) {
+  unsigned int i;
+  vector<Branch>& branches = fo->branches;
+  family = fo;
+  size = branches.size();
+  x.resize(size);
+  y.resize(size);
+  width.resize(size);
+  height.resize(size);
+  gx.resize(size);
+  gy.resize(size);
+  fx.resize(size);
+  fy.resize(size);
+  frames.resize(4*size);
+  spans.resize(4*size);
+  for(i = 0; i < size; i++) {
+    x[i] = branches[i].x;
+    y[i] = branches[i].y;
+    width[i] = branches[i].width;
+    height[i] = branches[i].height;
+  }
+}
+
+/*
+ * Copy positions back to the branches.
+ */
+void
+Layout::store() {
+  unsigned int i;
+  vector<Branch>& branches = family->branches;
+  for(i = 0; i < size; i++) {
+    branches[i].x = x[i];
+    branches[i].y = y[i];
+  }
+}
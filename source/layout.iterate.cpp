@@ -0,0 +1,100 @@
+/* file: layout.iterate.cpp
+  Copyright (C) 2008 Ville-Petteri Makinen
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the
+  Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+  CITATION (if not provided by software website)
+    Makinen V-P, software name, URL:http://www.iki.fi/~vpmakine/
+
+  CONTACT (if not provided by citation)
+    Ville-Petteri Makinen
+ 
+    Folkhalsan Research Center
+    Biomedicum Helsinki P.O.Box 63
+    Haartmaninkatu 8 00014, Helsinki, Finland
+    Tel: +358 9 191 25462
+    Fax: +358 9 191 25452
+
+    WWW:   http://www.iki.fi/~vpmakine
+*/
+
+#include "familyobject.h"
+
+/*
+ * One annealing step. Gradients are accumulated in the scratch buffers
+ * and every branch is moved by at most the current temperature.
+ */
+void
+Layout::iterate(const float temp, RNG& rng, const float range) {
+  unsigned int i;
+  unsigned int n = size;
+  float wx, wy, r;
+  float box[4] = {FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX};
+  float f[2];
+  if(n < 2) return;  
+
+  /* Determine geometric cost. */
+  for(i = 0; i < n; i++) {
+    wx = x[i];
+    wy = y[i];
+    if(wx < box[0]) box[0] = wx;
+    if(wy < box[1]) box[1] = wy;
+    wx += width[i];
+    wy += height[i];
+    if(wx > box[2]) box[2] = wx;
+    if(wy > box[3]) box[3] = wy;
+    gx[i] = 0.0;
+    gy[i] = 0.0;
+  }
+  wx = pow((box[2] - box[0]), 2);  
+  wy = pow((box[3] - box[1]), 2);  
+  r = 0.5*(wx + wy + 1e-6);
+  wx /= r;
+  wy /= r;
+
+  /* Compute gradients. */
+  if(range > 0.0) repel_grid(wx, wy, rng, range);
+  for(i = 0; i < n; i++) {
+    if(range <= 0.0) repel_row(i, wx, wy, rng);
+    attract(i, rng, f);
+    gx[i] += (0.8 + 0.2*rng.uniform())*f[0];
+    gy[i] += (0.8 + 0.2*rng.uniform())*f[1];
+  }
+
+  /* Central attractor. */
+  float w = 0.5*(box[2] - box[0] + 1e-6);
+  float h = 0.5*(box[3] - box[1] + 1e-6);
+  float x0 = 0.5*(box[2] + box[0]);
+  float y0 = 0.5*(box[3] + box[1]);
+  r = sqrt(w*w + h*h);
+  for(i = 0; i < n; i++) {
+    wx = (x0 - x[i] - 0.5*(width[i]))/r;
+    wy = (y0 - y[i] - 0.5*(height[i]))/r;
+    gx[i] += wx;
+    gy[i] += wy;
+  }
+
+  /* Update positions. */
+  for(i = 0; i < n; i++) {
+    r = sqrt(gx[i]*gx[i] + gy[i]*gy[i]);
+    if(r > temp) {
+      gx[i] *= temp/r;
+      gy[i] *= temp/r;
+    }
+    x[i] += (gx[i] - box[0]);
+    y[i] += (gy[i] - box[1]);
+  }
+}
@@ -0,0 +1,450 @@
+/* file: layout.repel.cpp
+  Copyright (C) 2008 Ville-Petteri Makinen
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the
+  Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+  CITATION (if not provided by software website)
+    Makinen V-P, software name, URL:http://www.iki.fi/~vpmakine/
+
+  CONTACT (if not provided by citation)
+    Ville-Petteri Makinen
+ 
+    Folkhalsan Research Center
+    Biomedicum Helsinki P.O.Box 63
+    Haartmaninkatu 8 00014, Helsinki, Finland
+    Tel: +358 9 191 25462
+    Fax: +358 9 191 25452
+
+    WWW:   http://www.iki.fi/~vpmakine
+*/
+
+#include "familyobject.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LAYOUT_SIMD
+#include <immintrin.h>
+#endif
+
+typedef void (*ForceKernel)(const Layout&, const unsigned int, unsigned int,
+			    float*, float*);
+
+static float overlap(const Layout&, const unsigned int, const unsigned int);
+static ForceKernel select_kernel(const string&);
+static void forces_scalar(const Layout&, const unsigned int, unsigned int,
+			  float*, float*);
+#ifdef LAYOUT_SIMD
+static void forces_avx2(const Layout&, const unsigned int, unsigned int,
+			float*, float*);
+static void forces_avx512(const Layout&, const unsigned int, unsigned int,
+			  float*, float*);
+#endif
+
+static ForceKernel Kernel = select_kernel("");
+
+/*
+ * Repulsion gradient of the first branch away from the second. The
+ * gradient is written to g.
+ */
+static inline void
+force(const Layout& lt, const unsigned int i, const unsigned int j,
+      float* g) {
+  float amp, r, dx, dy;
+  dx = (lt.x[i] - lt.x[j]);
+  dy = (lt.y[i] - lt.y[j]);
+  dx += 0.5*(lt.width[i] - lt.width[j]);
+  dy += 0.5*(lt.height[i] - lt.height[j]);
+  r = (dx*dx + dy*dy);
+  amp = overlap(lt, i, j);
+  g[0] = amp*dx/r;
+  g[1] = amp*dy/r;
+}
+
+/*
+ *
+ */
+void
+Layout::repel(const unsigned int i, const unsigned int j, float* g) const {
+  g[0] = 0.0;
+  g[1] = 0.0;
+  if(i == j) return;
+  force(*this, i, j, g);
+}
+
+/*
+ * Exact repulsion between a branch and every branch after it. The
+ * gradient weights wx and wy come from the shape of the bounding box.
+ */
+void
+Layout::repel_row(const unsigned int i, const float wx, const float wy,
+		  RNG& rng) {
+  unsigned int j;
+  forces(i);
+  for(j = (i + 1); j < size; j++) {
+    gx[i] += (wy + 0.2*rng.uniform())*fx[j];
+    gy[i] += (wx + 0.2*rng.uniform())*fy[j];
+    gx[j] -= (wy + 0.2*rng.uniform())*fx[j];
+    gy[j] -= (wx + 0.2*rng.uniform())*fy[j];
+  }
+}
+
+/*
+ * Repulsion gradients of a branch away from every branch after it,
+ * written to fx and fy at the index of the other branch. The kernel is
+ * chosen once by the processor features; all kernels give bit-identical
+ * results, so the layout does not depend on the machine.
+ */
+void
+Layout::forces(const unsigned int i) {
+  if((i + 1) >= size) return;
+  Kernel(*this, i, (i + 1), fx.data(), fy.data());
+}
+
+/*
+ * Name of the active force kernel.
+ */
+string
+Layout::kernel() {
+  if(Kernel == forces_scalar) return "scalar";
+#ifdef LAYOUT_SIMD
+  if(Kernel == forces_avx2) return "avx2";
+  if(Kernel == forces_avx512) return "avx512";
+#endif
+  return "";
+}
+
+/*
+ * Select a force kernel by name. Returns false if the kernel is not
+ * supported by the processor.
+ */
+bool
+Layout::kernel(const string& name) {
+  ForceKernel k = select_kernel(name);
+  if(k == NULL) return false;
+  Kernel = k;
+  return true;
+}
+
+/*
+ * The widest kernel the processor supports, or the named one. An empty
+ * name means automatic selection.
+ */
+static ForceKernel
+select_kernel(const string& name) {
+  if(name == "scalar") return forces_scalar;
+#ifdef LAYOUT_SIMD
+  __builtin_cpu_init();
+  bool avx2 = __builtin_cpu_supports("avx2");
+  bool avx512 = __builtin_cpu_supports("avx512f");
+  if(name == "") {
+    if(avx512) return forces_avx512;
+    if(avx2) return forces_avx2;
+  }
+  if((name == "avx2") && avx2) return forces_avx2;
+  if((name == "avx512") && avx512) return forces_avx512;
+#endif
+  if(name == "") return forces_scalar;
+  return NULL;
+}
+
+/*
+ *
+ */
+static void
+forces_scalar(const Layout& lt, const unsigned int i, unsigned int j,
+	      float* fx, float* fy) {
+  float f[2];
+  for(; j < lt.size; j++) {
+    force(lt, i, j, f);
+    fx[j] = f[0];
+    fy[j] = f[1];
+  }
+}
+
+#ifdef LAYOUT_SIMD
+
+/*
+ * Eight branches per instruction, with masked loads for the tail so that
+ * no scalar code runs in between. The operations are those of force() and
+ * overlap() in the same order; the reciprocal is taken in double precision
+ * as in overlap(). Fused multiply-add is not enabled, since it would round
+ * differently from the scalar code.
+ */
+__attribute__((target("avx2")))
+static void
+forces_avx2(const Layout& lt, const unsigned int i, unsigned int j,
+	    float* fx, float* fy) {
+  const float* x = lt.x.data();
+  const float* y = lt.y.data();
+  const float* w = lt.width.data();
+  const float* h = lt.height.data();
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 half = _mm256_set1_ps(0.5f);
+  const __m256 field = _mm256_set1_ps(REPULSION_FIELD);
+  const __m256d one = _mm256_set1_pd(1.0);
+  const __m256d eps = _mm256_set1_pd(1e-10);
+  const __m256 xi = _mm256_set1_ps(x[i]);
+  const __m256 yi = _mm256_set1_ps(y[i]);
+  const __m256 wi = _mm256_set1_ps(w[i]);
+  const __m256 hi = _mm256_set1_ps(h[i]);
+  const __m256 xmin1 = _mm256_sub_ps(xi, field);
+  const __m256 ymin1 = _mm256_sub_ps(yi, field);
+  const __m256 xmax1 = _mm256_add_ps(_mm256_add_ps(xi, wi), field);
+  const __m256 ymax1 = _mm256_add_ps(_mm256_add_ps(yi, hi), field);
+  const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  for(; j < lt.size; j += 8) {
+    int rest = (lt.size - j);
+    __m256i m = _mm256_cmpgt_epi32(_mm256_set1_epi32(rest), lanes);
+    __m256 xj = _mm256_maskload_ps(x + j, m);
+    __m256 yj = _mm256_maskload_ps(y + j, m);
+    __m256 wj = _mm256_maskload_ps(w + j, m);
+    __m256 hj = _mm256_maskload_ps(h + j, m);
+
+    /* Direction between centers. */
+    __m256 dx = _mm256_sub_ps(xi, xj);
+    __m256 dy = _mm256_sub_ps(yi, yj);
+    dx = _mm256_add_ps(dx, _mm256_mul_ps(half, _mm256_sub_ps(wi, wj)));
+    dy = _mm256_add_ps(dy, _mm256_mul_ps(half, _mm256_sub_ps(hi, hj)));
+    __m256 r = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+
+    /* Gap between padded frames. */
+    __m256 xmin2 = _mm256_sub_ps(xj, field);
+    __m256 ymin2 = _mm256_sub_ps(yj, field);
+    __m256 xmax2 = _mm256_add_ps(_mm256_add_ps(xj, wj), field);
+    __m256 ymax2 = _mm256_add_ps(_mm256_add_ps(yj, hj), field);
+    __m256 ox = _mm256_max_ps(_mm256_sub_ps(xmin1, xmax2), zero);
+    __m256 oy = _mm256_max_ps(_mm256_sub_ps(ymin1, ymax2), zero);
+    ox = _mm256_max_ps(_mm256_sub_ps(xmin2, xmax1), ox);
+    oy = _mm256_max_ps(_mm256_sub_ps(ymin2, ymax1), oy);
+    __m256 s = _mm256_add_ps(_mm256_mul_ps(ox, ox), _mm256_mul_ps(oy, oy));
+
+    /* Overlap amplitude. */
+    __m256d lo = _mm256_cvtps_pd(_mm256_castps256_ps128(s));
+    __m256d up = _mm256_cvtps_pd(_mm256_extractf128_ps(s, 1));
+    lo = _mm256_div_pd(one, _mm256_add_pd(lo, eps));
+    up = _mm256_div_pd(one, _mm256_add_pd(up, eps));
+    __m256 amp = _mm256_castps128_ps256(_mm256_cvtpd_ps(lo));
+    amp = _mm256_insertf128_ps(amp, _mm256_cvtpd_ps(up), 1);
+
+    _mm256_maskstore_ps(fx + j, m, _mm256_div_ps(_mm256_mul_ps(amp, dx), r));
+    _mm256_maskstore_ps(fy + j, m, _mm256_div_ps(_mm256_mul_ps(amp, dy), r));
+  }
+}
+
+/*
+ * Sixteen branches per instruction, with masked loads for the tail. The
+ * compiler may contract products and sums into fused multiply-adds when
+ * AVX-512 is enabled, so contraction is switched off here.
+ */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+__attribute__((target("avx512f"), optimize("fp-contract=off")))
+static void
+forces_avx512(const Layout& lt, const unsigned int i, unsigned int j,
+	      float* fx, float* fy) {
+  const float* x = lt.x.data();
+  const float* y = lt.y.data();
+  const float* w = lt.width.data();
+  const float* h = lt.height.data();
+  const __m512 zero = _mm512_setzero_ps();
+  const __m512 half = _mm512_set1_ps(0.5f);
+  const __m512 field = _mm512_set1_ps(REPULSION_FIELD);
+  const __m512d one = _mm512_set1_pd(1.0);
+  const __m512d eps = _mm512_set1_pd(1e-10);
+  const __m512 xi = _mm512_set1_ps(x[i]);
+  const __m512 yi = _mm512_set1_ps(y[i]);
+  const __m512 wi = _mm512_set1_ps(w[i]);
+  const __m512 hi = _mm512_set1_ps(h[i]);
+  const __m512 xmin1 = _mm512_sub_ps(xi, field);
+  const __m512 ymin1 = _mm512_sub_ps(yi, field);
+  const __m512 xmax1 = _mm512_add_ps(_mm512_add_ps(xi, wi), field);
+  const __m512 ymax1 = _mm512_add_ps(_mm512_add_ps(yi, hi), field);
+  for(; j < lt.size; j += 16) {
+    __mmask16 m = 0xffff;
+    if((lt.size - j) < 16) m = (__mmask16)((1u << (lt.size - j)) - 1);
+    __m512 xj = _mm512_maskz_loadu_ps(m, x + j);
+    __m512 yj = _mm512_maskz_loadu_ps(m, y + j);
+    __m512 wj = _mm512_maskz_loadu_ps(m, w + j);
+    __m512 hj = _mm512_maskz_loadu_ps(m, h + j);
+
+    /* Direction between centers. */
+    __m512 dx = _mm512_sub_ps(xi, xj);
+    __m512 dy = _mm512_sub_ps(yi, yj);
+    dx = _mm512_add_ps(dx, _mm512_mul_ps(half, _mm512_sub_ps(wi, wj)));
+    dy = _mm512_add_ps(dy, _mm512_mul_ps(half, _mm512_sub_ps(hi, hj)));
+    __m512 r = _mm512_add_ps(_mm512_mul_ps(dx, dx), _mm512_mul_ps(dy, dy));
+
+    /* Gap between padded frames. */
+    __m512 xmin2 = _mm512_sub_ps(xj, field);
+    __m512 ymin2 = _mm512_sub_ps(yj, field);
+    __m512 xmax2 = _mm512_add_ps(_mm512_add_ps(xj, wj), field);
+    __m512 ymax2 = _mm512_add_ps(_mm512_add_ps(yj, hj), field);
+    __m512 ox = _mm512_max_ps(_mm512_sub_ps(xmin1, xmax2), zero);
+    __m512 oy = _mm512_max_ps(_mm512_sub_ps(ymin1, ymax2), zero);
+    ox = _mm512_max_ps(_mm512_sub_ps(xmin2, xmax1), ox);
+    oy = _mm512_max_ps(_mm512_sub_ps(ymin2, ymax1), oy);
+    __m512 s = _mm512_add_ps(_mm512_mul_ps(ox, ox), _mm512_mul_ps(oy, oy));
+
+    /* Overlap amplitude. */
+    __m512d lo = _mm512_cvtps_pd(_mm512_castps512_ps256(s));
+    __m512d up = _mm512_cvtps_pd(_mm256_castpd_ps(
+      _mm512_extractf64x4_pd(_mm512_castps_pd(s), 1)));
+    lo = _mm512_div_pd(one, _mm512_add_pd(lo, eps));
+    up = _mm512_div_pd(one, _mm512_add_pd(up, eps));
+    __m512d amp2 = _mm512_castpd256_pd512(
+      _mm256_castps_pd(_mm512_cvtpd_ps(lo)));
+    amp2 = _mm512_insertf64x4(amp2, _mm256_castps_pd(_mm512_cvtpd_ps(up)), 1);
+    __m512 amp = _mm512_castpd_ps(amp2);
+
+    _mm512_mask_storeu_ps(fx + j, m,
+			  _mm512_div_ps(_mm512_mul_ps(amp, dx), r));
+    _mm512_mask_storeu_ps(fy + j, m,
+			  _mm512_div_ps(_mm512_mul_ps(amp, dy), r));
+  }
+}
+#pragma GCC diagnostic pop
+
+#endif /* LAYOUT_SIMD */
+
+/*
+ * Register the branches in a uniform grid. The frame of each branch is
+ * padded by the margin and the branch is listed in every cell that the
+ * frame touches. Cells are at least as large as the range and the
+ * average frame, and there are at most a few cells per branch.
+ */
+void
+Layout::grid(const float margin, const float range) {
+  unsigned int i, c;
+  int cx, cy;
+  unsigned int n = size;
+  float bounds[4] = {FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX};
+  double extent = 0.0;
+
+  /* Padded frames. */
+  for(i = 0; i < n; i++) {
+    float* p = &(frames[4*i]);
+    p[0] = (x[i] - margin);
+    p[1] = (y[i] - margin);
+    p[2] = (x[i] + width[i] + margin);
+    p[3] = (y[i] + height[i] + margin);
+    if(p[0] < bounds[0]) bounds[0] = p[0];
+    if(p[1] < bounds[1]) bounds[1] = p[1];
+    if(p[2] > bounds[2]) bounds[2] = p[2];
+    if(p[3] > bounds[3]) bounds[3] = p[3];
+    extent += max(p[2] - p[0], p[3] - p[1]);
+  }
+
+  /* Cell size. */
+  float cell = max((double)range, extent/n);
+  int nx = (int)((bounds[2] - bounds[0])/cell) + 1;
+  int ny = (int)((bounds[3] - bounds[1])/cell) + 1;
+  while((1.0*nx*ny) > (4.0*n + 16)) {
+    cell *= 2;
+    nx = (int)((bounds[2] - bounds[0])/cell) + 1;
+    ny = (int)((bounds[3] - bounds[1])/cell) + 1;
+  }
+  grid_origin[0] = bounds[0];
+  grid_origin[1] = bounds[1];
+  grid_cell = cell;
+  grid_nx = nx;
+
+  /* Register branches in cells. The buffers keep their capacity between
+     iterations. */
+  unsigned int n_cells = nx*ny;
+  cells.assign(n_cells + 1, 0);
+  for(i = 0; i < n; i++) {
+    int* s = &(spans[4*i]);
+    s[0] = (int)((frames[4*i] - bounds[0])/cell);
+    s[1] = (int)((frames[4*i + 1] - bounds[1])/cell);
+    s[2] = min((int)((frames[4*i + 2] - bounds[0])/cell), (nx - 1));
+    s[3] = min((int)((frames[4*i + 3] - bounds[1])/cell), (ny - 1));
+    for(cy = s[1]; cy <= s[3]; cy++)
+      for(cx = s[0]; cx <= s[2]; cx++)
+	cells[cy*nx + cx + 1]++;
+  }
+  for(c = 0; c < n_cells; c++)
+    cells[c + 1] += cells[c];
+  cursor.assign(cells.begin(), (cells.end() - 1));
+  items.resize(cells[n_cells]);
+  for(i = 0; i < n; i++) {
+    int* s = &(spans[4*i]);
+    for(cy = s[1]; cy <= s[3]; cy++)
+      for(cx = s[0]; cx <= s[2]; cx++)
+	items[cursor[cy*nx + cx]++] = i;
+  }
+}
+
+/*
+ * Repulsion between branches whose padded frames are closer than the
+ * range; more distant pairs are ignored. Each branch is registered in
+ * every grid cell that its frame, grown by half the range, touches. A pair
+ * is evaluated only in the cell that holds the lower corner of the
+ * intersection of the two grown frames, so that it is visited once.
+ */
+void
+Layout::repel_grid(const float wx, const float wy, RNG& rng,
+		   const float range) {
+  unsigned int i, j, a, b, c;
+  int cx, cy;
+  float f[2];
+  grid((REPULSION_FIELD + 0.5*range), range);
+
+  /* Evaluate pairs. Branches within a cell are in ascending order. */
+  unsigned int n_cells = (cells.size() - 1);
+  for(c = 0; c < n_cells; c++) {
+    for(a = cells[c]; a < cells[c + 1]; a++) {
+      i = items[a];
+      float* p = &(frames[4*i]);
+      for(b = (a + 1); b < cells[c + 1]; b++) {
+	j = items[b];
+	float* q = &(frames[4*j]);
+	if((p[0] > q[2]) || (q[0] > p[2])) continue;
+	if((p[1] > q[3]) || (q[1] > p[3])) continue;
+	cx = (int)((max(p[0], q[0]) - grid_origin[0])/grid_cell);
+	cy = (int)((max(p[1], q[1]) - grid_origin[1])/grid_cell);
+	if((unsigned int)(cy*grid_nx + cx) != c) continue;
+	force(*this, i, j, f);
+	gx[i] += (wy + 0.2*rng.uniform())*f[0];
+	gy[i] += (wx + 0.2*rng.uniform())*f[1];
+	gx[j] -= (wy + 0.2*rng.uniform())*f[0];
+	gy[j] -= (wx + 0.2*rng.uniform())*f[1];
+      }
+    }
+  }
+}
+
+/*
+ * Check if bounding frames overlap.
+ */
+static float
+overlap(const Layout& lt, const unsigned int i, const unsigned int j) {
+  float xmin1 = (lt.x[i] - REPULSION_FIELD);
+  float ymin1 = (lt.y[i] - REPULSION_FIELD);
+  float xmax1 = (lt.x[i] + lt.width[i] + REPULSION_FIELD);
+  float ymax1 = (lt.y[i] + lt.height[i] + REPULSION_FIELD);
+  float xmin2 = (lt.x[j] - REPULSION_FIELD);
+  float ymin2 = (lt.y[j] - REPULSION_FIELD);
+  float xmax2 = (lt.x[j] + lt.width[j] + REPULSION_FIELD);
+  float ymax2 = (lt.y[j] + lt.height[j] + REPULSION_FIELD);
+  float dx = 0.0;
+  float dy = 0.0;
+
+  if(xmin1 > xmax2) dx = (xmin1 - xmax2); 
+  if(xmin2 > xmax1) dx = (xmin2 - xmax1); 
+  if(ymin1 > ymax2) dy = (ymin1 - ymax2); 
+  if(ymin2 > ymax1) dy = (ymin2 - ymax1); 
+
+  return 1./(dx*dx + dy*dy + 1e-10);
+}
@@ -36,8 +36,8 @@
 /*
  *
  */
-Member::Member(const string& s) {
-  m_name = s;
+Member::Member(const unsigned int id) {
+  m_name = id;
   is_original = false;
   gender = '\0';
   father = -1;
@@ -45,7 +45,7 @@ using namespace std;
 
 class Member {
 private:
-  string m_name;
+  unsigned int m_name;
 public:
   bool is_original;
   char gender;
@@ -64,8 +64,8 @@ public:
   float up_attach;
   vector<int> bonds;
 public:
-  Member(const string&);
-  string name() {return m_name;};
+  Member(const unsigned int);
+  unsigned int name() {return m_name;};
 };
 
 #endif /* member_INCLUDED */
@@ -0,0 +1,141 @@
+/* file: name.cpp
+  Copyright (C) 2008 Ville-Petteri Makinen
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the
+  Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+  CITATION (if not provided by software website)
+    Makinen V-P, software name, URL:http://www.iki.fi/~vpmakine/
+
+  CONTACT (if not provided by citation)
+    Ville-Petteri Makinen
+ 
+    Folkhalsan Research Center
+    Biomedicum Helsinki P.O.Box 63
+    Haartmaninkatu 8 00014, Helsinki, Finland
+    Tel: +358 9 191 25462
+    Fax: +358 9 191 25452
+
+    WWW:   http://www.iki.fi/~vpmakine
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include "cranefoot.h"
+
+#define CHUNK_BITS 10
+#define N_CHUNKS   23
+
+using namespace std;
+using namespace cranefoot;
+
+/*
+ * Strings are kept in chunks that are never moved, so that references
+ * and views to existing entries remain valid when the table grows. Chunk
+ * k holds 1024*2^k strings. A new string is written before the count is
+ * raised, so readers that see an id below the count can use it without
+ * locking. Only intern() and find() lock, for the reverse map.
+ */
+class NameTable {
+public:
+  mutex lock;
+  atomic<unsigned int> count;
+  atomic<string*> chunks[N_CHUNKS];
+  unordered_map<string_view, unsigned int> ids;
+public:
+  NameTable() {
+    for(unsigned int k = 0; k < N_CHUNKS; k++)
+      chunks[k] = NULL;
+    count = 0;
+    add("");
+  };
+  ~NameTable() {
+    for(unsigned int k = 0; k < N_CHUNKS; k++)
+      delete [] chunks[k].load();
+  };
+  string& at(const unsigned int id) const {
+    uint64_t x = ((uint64_t)id + (1 << CHUNK_BITS));
+    unsigned int k = (63 - __builtin_clzll(x) - CHUNK_BITS);
+    string* chunk = chunks[k].load(memory_order_relaxed);
+    return chunk[x - ((uint64_t)1 << (k + CHUNK_BITS))];
+  };
+  unsigned int add(const string& s) {
+    unsigned int id = count.load(memory_order_relaxed);
+    uint64_t x = ((uint64_t)id + (1 << CHUNK_BITS));
+    unsigned int k = (63 - __builtin_clzll(x) - CHUNK_BITS);
+    if(chunks[k].load(memory_order_relaxed) == NULL)
+      chunks[k].store(new string[(size_t)1 << (k + CHUNK_BITS)],
+		      memory_order_relaxed);
+    string& slot = at(id);
+    slot = s;
+    ids[string_view(slot)] = id;
+    count.store((id + 1), memory_order_release);
+    return id;
+  };
+};
+
+static NameTable&
+table() {
+  static NameTable names;
+  return names;
+}
+
+/*
+ *
+ */
+unsigned int
+Name::find(const string& s) {
+  if(s.length() < 1) return 0;
+  NameTable& names = table();
+  lock_guard<mutex> guard(names.lock);
+  unordered_map<string_view, unsigned int>::iterator pos;
+  if((pos = names.ids.find(string_view(s))) != names.ids.end())
+    return pos->second;
+  return Name::invalid;
+}
+
+/*
+ *
+ */
+unsigned int
+Name::intern(const string& s) {
+  if(s.length() < 1) return 0;
+  NameTable& names = table();
+  lock_guard<mutex> guard(names.lock);
+  unordered_map<string_view, unsigned int>::iterator pos;
+  if((pos = names.ids.find(string_view(s))) != names.ids.end())
+    return pos->second;
+  if(names.count >= Name::invalid) {
+    fprintf(stderr, "ERROR! %s at line %d: Too many names.\n",
+	    __FILE__, __LINE__);
+    exit(1);
+  }
+  return names.add(s);
+}
+
+/*
+ * Lock-free: the string behind a published id is never modified.
+ */
+const string&
+Name::text(const unsigned int id) {
+  NameTable& names = table();
+  if(id >= names.count.load(memory_order_acquire)) return names.at(0);
+  return names.at(id);
+}
@@ -33,6 +33,9 @@
 
 #include "pedigreeobject.h"
 
+static void load(const vector<string>&, char, const map<string, vector<string> >&,
+		 unsigned int, vector<Table>&, vector<double>&);
+static void report(const Table&, double, bool);
 static void detect(map<string, Locus>&, Table&, bool);
 static void detect_text(vector<Locus>&, Table&, bool);
 
@@ -45,52 +48,16 @@ PedigreeObject::configure() {
   unsigned int i;
   string s, ped_file;
   vector<Locus> loci;
-  Table data;
+  map<string, vector<string> > projections;
+  map<string, map<string, Locus> >::iterator pos;
+  map<string, Locus>::iterator lpos;
 
   /* Determine delimiter. */
   s = (cfg["Delimiter"][1] + "\t");
   delim = s[0];
   if(s == "tab\t") delim = '\t';
   if(s == "ws\t") delim = '\0';
-  if(verbose_mode) {
-    if(delim == '\0')
-      cout << "\nLoading white space delimited data:\n";
-    else if(delim == '\t')
-      cout << "\nLoading tabulator delimited data:\n";
-    else
-      cout << "\nLoading '" << delim << "' delimited data:\n";
-  }
-
-  /* Copy data from primary pedigree file. */
   ped_file = cfg.getPedigreeFilename();
-  data = Table(ped_file, delim);
-  if(data.size() < 1) {
-    cout << "WARNING! File '" << ped_file
-	 << "' is empty or cannot be opened.\n";
-    return false;
-  }
-  if(verbose_mode) {
-    cout << "\tCopied " << clarify(data.mem_size()) << " bytes from '"
-	 << ped_file << "'.\n";
-  }
-
-  /* Check that pedigree file contains necessary variables. */
-  if(data.column(cfg["NameVariable"][1]) < 0) {
-    cout << "WARNING! Could not find name variable in '"
-	 << ped_file << "'.\n";
-    return false;
-  }
-  if(data.column(cfg["FatherVariable"][1]) < 0) {
-    cout << "WARNING! Could not find father variable in '"
-	 << ped_file << "'.\n";
-    return false;
-  }
-  if(data.column(cfg["MotherVariable"][1]) < 0) {
-    cout << "WARNING! Could not find mother variable in '"
-	 << ped_file << "'.\n";
-    return false;
-  }
-  tables[ped_file] = data;
 
   /* Read variable instructions. */
   loci.push_back(Locus("AgeVariable", cfg["AgeVariable"]));
@@ -126,33 +93,84 @@ PedigreeObject::configure() {
     variables[file_name][locus_name] = loci[i];
   }
 
-  /* Copy data from secondary input files. */
-  map<string, map<string, Locus> >::iterator pos;
+  /* Collect the columns each file must provide. Names and ages are
+     looked up in every file. */
   for(pos = variables.begin(); pos != variables.end(); pos++) {
-    if(tables.count(pos->first) > 0) continue;
-    data = Table(pos->first, delim); 
-    if(data.size() < 1) {
-      cout << "WARNING! File '" << pos->first
-	   << "' is empty or cannot be opened.\n";
-    }
-    else if(verbose_mode) {
-      cout << "\tCopied " << clarify(data.mem_size()) << " bytes from '"
-	   << data.source() << "'.\n";
+    vector<string>& headings = projections[pos->first];
+    headings.push_back(cfg["NameVariable"][1]);
+    headings.push_back(cfg["AgeVariable"][1]);
+    for(lpos = (pos->second).begin(); lpos != (pos->second).end(); lpos++)
+      headings.push_back((lpos->second).heading);
+  }
+  for(i = 0; i < text_variables.size(); i++) {
+    vector<string>& headings = projections[text_variables[i].file_name];
+    if(headings.size() < 1) {
+      headings.push_back(cfg["NameVariable"][1]);
+      headings.push_back(cfg["AgeVariable"][1]);
     }
-    tables[pos->first] = data;
+    headings.push_back(text_variables[i].heading);
+  }
+
+  /* List input files, the pedigree file comes first. */
+  vector<string> files(1, ped_file);
+  for(pos = variables.begin(); pos != variables.end(); pos++) {
+    if(find(files.begin(), files.end(), pos->first) != files.end()) continue;
+    files.push_back(pos->first);
   }
   for(i = 0; i < text_variables.size(); i++) {
     s = text_variables[i].file_name;
-    if(tables.count(s) > 0) continue;
-    data = Table(s, delim); 
-    if(data.size() < 1)
-      cout << "WARNING! File '" << s << "' is empty or cannot be opened.\n";
-    else if(verbose_mode) {
-      cout << "\tCopied " << clarify(data.mem_size()) << " bytes from '"
-	   << data.source() << "'.\n";
-    }
-    tables[s] = data;
+    if(find(files.begin(), files.end(), s) != files.end()) continue;
+    files.push_back(s);
+  }
+
+  /* Load all files concurrently. */
+  vector<Table> data(files.size());
+  vector<double> seconds(files.size(), 0.0);
+  if(verbose_mode) {
+    if(delim == '\0')
+      cout << "\nLoading white space delimited data:\n";
+    else if(delim == '\t')
+      cout << "\nLoading tabulator delimited data:\n";
+    else
+      cout << "\nLoading '" << delim << "' delimited data:\n";
+  }
+  load(files, delim, projections, n_threads, data, seconds);
+
+  /* Check primary pedigree file. */
+  if(data[0].size() < 1) {
+    cout << "WARNING! File '" << ped_file
+	 << "' is empty or cannot be opened.\n";
+    return false;
   }
+  report(data[0], seconds[0], verbose_mode);
+
+  /* Check that pedigree file contains necessary variables. */
+  if(data[0].column(cfg["NameVariable"][1]) < 0) {
+    cout << "WARNING! Could not find name variable in '"
+	 << ped_file << "'.\n";
+    return false;
+  }
+  if(data[0].column(cfg["FatherVariable"][1]) < 0) {
+    cout << "WARNING! Could not find father variable in '"
+	 << ped_file << "'.\n";
+    return false;
+  }
+  if(data[0].column(cfg["MotherVariable"][1]) < 0) {
+    cout << "WARNING! Could not find mother variable in '"
+	 << ped_file << "'.\n";
+    return false;
+  }
+
+  /* Report secondary input files in the original order. */
+  for(i = 1; i < files.size(); i++) {
+    if(data[i].size() < 1)
+      cout << "WARNING! File '" << files[i]
+	   << "' is empty or cannot be opened.\n";
+    else
+      report(data[i], seconds[i], verbose_mode);
+  }
+  for(i = 0; i < files.size(); i++)
+    tables[files[i]] = data[i];
 
   /* Detect and check variables from files. */
   map<string, Table>::iterator iter;
@@ -179,6 +197,58 @@ PedigreeObject::configure() {
   return true;
 }
 
+/*
+ * Load tables in parallel. Each file is read by one worker, the elapsed
+ * wall-clock time is stored for each file. The thread limit is shared:
+ * the threads left over from the file workers index large files.
+ */
+static void
+load(const vector<string>& files, char delim,
+     const map<string, vector<string> >& projections, unsigned int limit,
+     vector<Table>& data, vector<double>& seconds) {
+  unsigned int k;
+  unsigned int n = files.size();
+  unsigned int n_workers = min(n, max(limit, 1u));
+  atomic<unsigned int> next(0);
+  vector<thread> workers;
+  auto work = [&]() {
+    unsigned int j;
+    while((j = next++) < n) {
+      auto start = chrono::steady_clock::now();
+      map<string, vector<string> >::const_iterator pos;
+      if((pos = projections.find(files[j])) != projections.end())
+	data[j] = Table(files[j], delim, pos->second);
+      else
+	data[j] = Table(files[j], delim);
+      chrono::duration<double> dt = (chrono::steady_clock::now() - start);
+      seconds[j] = dt.count();
+    }
+  };
+
+  if(n_workers < 2) {
+    work();
+    return;
+  }
+  Table::threads(max(limit/n_workers, 1u));
+  for(k = 0; k < n_workers; k++)
+    workers.push_back(thread(work));
+  for(k = 0; k < n_workers; k++)
+    workers[k].join();
+  Table::threads(limit);
+}
+
+/*
+ *
+ */
+static void
+report(const Table& t, double seconds, bool verbose) {
+  char buf[32];
+  if(!verbose) return;
+  sprintf(buf, "%.3f", seconds);
+  cout << "\tCopied " << clarify(t.mem_size()) << " bytes from '"
+       << t.source() << "' in " << buf << "s.\n";
+}
+
 /*
  *
  */
@@ -187,7 +257,7 @@ detect(map<string, Locus>& loci, Table& t, bool verbose) {
   map<string, Locus>::iterator iter;
   for(iter = loci.begin(); iter != loci.end(); iter++) {
     (iter->second).column = t.column((iter->second).heading);
-    if(verbose) (iter->second).display();
+    if(verbose) (iter->second).display(t.position((iter->second).column));
   }
 }
 
@@ -200,6 +270,6 @@ detect_text(vector<Locus>& loci, Table& t, bool verbose) {
   for(i = 0; i < loci.size(); i++) {
     if(loci[i].file_name != t.source()) continue;
     loci[i].column = t.column(loci[i].heading);
-    if(verbose) loci[i].display();
+    if(verbose) loci[i].display(t.position(loci[i].column));
   }
 }
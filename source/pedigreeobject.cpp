@@ -41,6 +41,8 @@ static void print_checklist();
  *
  */
 PedigreeObject::PedigreeObject() {
+  verbose_mode = false;
+  n_threads = 1;
   print_greeting(1);
 }
 
@@ -48,6 +50,9 @@ PedigreeObject::PedigreeObject() {
  *
  */
 PedigreeObject::PedigreeObject(const string& fname, const string& pedigreeFile) {
+  verbose_mode = false;
+  n_threads = 1;
+
   /* Check configuration file. */
   cfg = ConfigTable(fname, '\0');
   if (!pedigreeFile.empty())
@@ -60,6 +65,13 @@ PedigreeObject::PedigreeObject(const string& fname, const string& pedigreeFile)
 
   /* Load data from input file(s). */
   verbose_mode = (cfg["VerboseMode"][1] != "off");
+  Table::snapshots(cfg["SnapshotMode"][1] == "on");
+  n_threads = thread::hardware_concurrency();
+  if(cfg.number("ThreadLimit", 1) >= 1.0)
+    n_threads = (unsigned int)(cfg.number("ThreadLimit", 1));
+  if(n_threads < 1) n_threads = 1;
+  Family::threads(n_threads);
+  Table::threads(n_threads);
   if(verbose_mode) print_greeting(0);
   if(!check_parameters(cfg)) {
     cerr << "ERROR! Erroneous instructions found.\n";
@@ -131,6 +143,18 @@ check_parameters(ConfigTable& cfg) {
     flag = false;
   }
 
+  /* Check annealing schedule. */
+  string mode = cfg["AnnealingMode"][1];
+  if((mode != "") && (mode != "time") && (mode != "iterations") &&
+     (mode != "convergence")) {
+    cout << "WARNING! Unknown annealing mode '" << mode << "'.\n";
+    flag = false;
+  }
+  if((mode == "iterations") && !(cfg.number("AnnealingMode", 2) >= 1.0)) {
+    cout << "WARNING! Iteration count not defined.\n";
+    flag = false;
+  }
+
   /* Check critical parameters. */
   if(cfg.getPedigreeFilename().size() < 2) {
     cout << "WARNING! Pedigree file not defined.\n";
@@ -222,6 +246,8 @@ print_greeting(int level) {
   cout << "\n";
 
   cout << "  # Formatting and functional instructions:\n";
+  cout << "  AnnealingChains        (integer)\n";
+  cout << "  AnnealingMode          time/iterations/convergence  (number)  (integer)\n";
   cout << "  BackgroundColor        (integer)\n";
   cout << "  Delimiter              tab/ws/(character)\n";
   cout << "  FigureLimit            (integer)\n";
@@ -230,6 +256,9 @@ print_greeting(int level) {
   cout << "  PageSize               a0...a5/letter  a0...a5/letter/auto\n";
   cout << "  PageOrientation        portrait/landscape\n";
   cout << "  RandomSeed             (integer)\n";
+  cout << "  RepulsionRange         (real)\n";
+  cout << "  SnapshotMode           on/off\n";
+  cout << "  ThreadLimit            (integer)\n";
   cout << "  TimeLimit              (real)\n";
   cout << "  VerboseMode            on/off\n";
   cout << "\n";
@@ -35,6 +35,10 @@
 #define pedigreeobject_INCLUDED
 
 #include <map>
+#include <unordered_map>
+#include <atomic>
+#include <chrono>
+#include <thread>
 #include <iostream>
 #include <algorithm>
 #include <stdlib.h>
@@ -47,6 +51,7 @@
 #include "tablet.h"
 #include "scriptum.h"
 #include "cranefoot_utilities.h"
+#include "rng.h"
 
 #define pedigree_VERSION "3.2.3"
 #define MALE             'M'
@@ -96,14 +101,14 @@ public:
     if(loc.rank > rank) return true;
     return false;
   }
-  void display() const {
+  void display(const int position) const {
     printf("\t%-22s ", l_name.c_str());
     if(heading.length() > 0) {
       string s = ("'" + file_name + "'");
       printf("%-16s ", s.c_str());
       s = ("'" + heading + "'");
       printf("%-16s ", s.c_str());
-      if(column >= 0) printf("[%2d]\n", (column + 1));
+      if(column >= 0) printf("[%2d]\n", (position + 1));
       else printf("not found\n");
     }
     else
@@ -124,19 +129,22 @@ private:
   float print_vlegend(PostScript&);
 public:
   bool verbose_mode;
+  unsigned int n_threads;
   ConfigTable cfg;
   vector<Locus> text_variables;
   map<string, Table> tables;
   map<string, map<string, Locus> > variables;
   map<string, Family> families;
-  map<string, Emblem> emblems;
+  unordered_map<unsigned int, Emblem> emblems;
 public:
   PedigreeObject();
   PedigreeObject(const string&, const string&);
   void print();
   bool run();
   Emblem emblem(const string& s) {
-    if(emblems.count(s) > 0) return emblems[s];
+    unsigned int id = Name::find(s);
+    if(emblems.count(id) > 0) return emblems[id];
+    return Emblem();
   };
   std::string name() {return cfg.getPedigreeName();};
   unsigned int size() {return emblems.size();};
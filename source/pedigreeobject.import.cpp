@@ -33,7 +33,27 @@
 
 #include "pedigreeobject.h"
 
-static void check_shape(Emblem&, string&, char);
+struct ImportJob {
+  Table* table;
+  int name_var;
+  int age_var;
+  int subgraph_var;
+  int arrow_var;
+  int color_var;
+  int gender_var;
+  int pattern_var;
+  int shape_var;
+  int slash_var;
+  int tracer_var;
+  vector<int> text_vars;
+  vector<int> hits;
+};
+
+static void join(vector<ImportJob>&, vector<Vertex>&, vector<Emblem>&,
+		 char, char, unsigned int);
+static void join_table(ImportJob&, vector<Vertex>&, vector<Emblem>&,
+		       char, char);
+static void check_shape(Emblem&, unsigned int, char);
 
 /*
  *
@@ -66,7 +86,7 @@ PedigreeObject::import() {
   Table& tped = tables[pedigreeFile];
   tped.sort(vector<int>(1, var1));
   for(i = 0; i < tped.size(); i++) {
-    Row r = tped[i];
+    RowView r = tped.view(i);
     if(r.rank() < 1) continue;
     if(r[var1] == "") continue;
     if(r[var1] == label) {
@@ -76,16 +96,16 @@ PedigreeObject::import() {
       continue;
     }
     Vertex v;
-    v.name = r[var1];
+    v.name = Name::intern(string(r[var1]));
     v.family_name = "family";
-    v.father = r[var2];
-    v.mother = r[var3];
+    v.father = Name::intern(string(r[var2]));
+    v.mother = Name::intern(string(r[var3]));
     v.age = 0.0;
     v.width = 2.0;
     v.height = 2.0;
     v.up_attach = 1.0;
     vertices.push_back(v);
-    label = v.name;
+    label = string(r[var1]);
   }
 
   /* Determine background color. */
@@ -105,65 +125,42 @@ PedigreeObject::import() {
   emb_null.text = vector<string>(text_variables.size(), "");
   ev = vector<Emblem>(vertices.size(), emb_null);
   
-  /* Update emblems from input file(s). */
+  /* Prepare one join per input file. */
+  vector<ImportJob> jobs;
   for(tpos = tables.begin(); tpos != tables.end(); tpos++) {
     Table& t = tpos->second;
-    
-    /* Visualization variables. */
     map<string, Locus>& loci = variables[tpos->first];
-    int name_var = t.column(cfg["NameVariable"][1]);
-    int age_var = t.column(cfg["AgeVariable"][1]);
-    int subgraph_var = loci["SubgraphVariable"].column;
-    int arrow_var = loci["ArrowVariable"].column;
-    int color_var = loci["ColorVariable"].column;
-    int gender_var = loci["GenderVariable"].column;
-    int pattern_var = loci["PatternVariable"].column;
-    int shape_var = loci["ShapeVariable"].column;
-    int slash_var = loci["SlashVariable"].column;
-    int tracer_var = loci["TracerVariable"].column;
-
-    /* Text variables. */
-    vector<int> text_vars(text_variables.size(), -1);
+    ImportJob job;
+    job.table = &t;
+    job.name_var = t.column(cfg["NameVariable"][1]);
+    job.age_var = t.column(cfg["AgeVariable"][1]);
+    job.subgraph_var = loci["SubgraphVariable"].column;
+    job.arrow_var = loci["ArrowVariable"].column;
+    job.color_var = loci["ColorVariable"].column;
+    job.gender_var = loci["GenderVariable"].column;
+    job.pattern_var = loci["PatternVariable"].column;
+    job.shape_var = loci["ShapeVariable"].column;
+    job.slash_var = loci["SlashVariable"].column;
+    job.tracer_var = loci["TracerVariable"].column;
+    job.text_vars = vector<int>(text_variables.size(), -1);
     for(k = 0; k < text_variables.size(); k++) {
       if(t.source() != text_variables[k].file_name) continue;
-      text_vars[k] = text_variables[k].column;
+      job.text_vars[k] = text_variables[k].column;
     }
+    jobs.push_back(job);
+  }
 
-    /* Import available information. */
-    t.sort(vector<int>(1, name_var));
+  /* Join tables in parallel. Each file owns its own attributes except
+     the age, which is resolved afterwards. */
+  join(jobs, vertices, ev, male, female, n_threads);
+
+  /* The last file with a matching row provides the age. */
+  for(k = 0; k < jobs.size(); k++) {
+    ImportJob& job = jobs[k];
+    if(job.age_var < 0) continue;
     for(i = 0; i < vertices.size(); i++) {
-      int ind = t.find(vertices[i].name, name_var);
-      Row r = t[ind];
-      if(r.size() < 1) continue;
-
-      /* Age and subgraph name. */
-      if(age_var >= 0)
-	vertices[i].age = r.number(age_var);
-      if(subgraph_var >= 0) 
-	vertices[i].family_name = r[subgraph_var];
-      
-      /* Visual features. */
-      if(arrow_var >= 0) ev[i].arrow = (r.number(arrow_var) > 0.0);
-      if(r[color_var].length() > 0) 
-	ev[i].color = (unsigned int)(r.number(color_var));
-      if(r.number(pattern_var) > 0.0) 
-	ev[i].pattern = (unsigned int)(r.number(pattern_var));
-      if(slash_var >= 0) ev[i].slash = (r.number(slash_var) > 0.0);
-      if(tracer_var >= 0) ev[i].tracer = (r.number(tracer_var) > 0.0);
-
-      /* Symbol shape. */
-      if(r[gender_var].length() > 0) {
-	if(r[gender_var][0] == male) ev[i].shape = 7;
-	if(r[gender_var][0] == female) ev[i].shape = 1;
-      }
-      if(r.number(shape_var) > 0.0)
-	ev[i].shape = (unsigned int)(r.number(shape_var));
- 
-      /* Text info. */
-      for(k = 0; k < text_vars.size(); k++) {
-	if(text_vars[k] < 0) continue;
-	ev[i].text[k] = r[text_vars[k]];
-      }
+      if(job.hits[i] < 0) continue;
+      vertices[i].age = job.table->view(job.hits[i]).number(job.age_var);
     }
   }    
 
@@ -178,7 +175,7 @@ PedigreeObject::import() {
   /* Get base font. */
   PostScript ps;
   float font_size = atof(ps["FontSize"].c_str());
-  if(cfg["FontSize"].size() > 1) font_size = cfg["FontSize"].number(1);
+  if(cfg["FontSize"].size() > 1) font_size = cfg.number("FontSize", 1);
   if(font_size < 1.0) font_size = 1.0;
   if(font_size > 100.0) font_size = 100.0;
 
@@ -213,10 +210,10 @@ PedigreeObject::import() {
     for(pos = families.begin(); pos != families.end(); i++, pos++) {
       vector<Node> nodes = (pos->second).nodes();
       for(i = 0; i < nodes.size(); i++) {
-	string& key_a = nodes[i].alpha;
-	string& key_b = nodes[i].beta;
-	if(key_a != "") check_shape(emblems[key_a], key_a, nodes[i].gender_a);
-	if(key_b != "") check_shape(emblems[key_b], key_b, nodes[i].gender_b);
+	unsigned int key_a = nodes[i].alpha;
+	unsigned int key_b = nodes[i].beta;
+	if(key_a != 0) check_shape(emblems[key_a], key_a, nodes[i].gender_a);
+	if(key_b != 0) check_shape(emblems[key_b], key_b, nodes[i].gender_b);
       }
     }
   }
@@ -232,23 +229,103 @@ PedigreeObject::import() {
   return true;
 }
 
+/*
+ * Run the joins on a pool of at most limit worker threads.
+ */
+static void
+join(vector<ImportJob>& jobs, vector<Vertex>& vertices, vector<Emblem>& ev,
+     char male, char female, unsigned int limit) {
+  unsigned int k;
+  unsigned int n = jobs.size();
+  unsigned int n_threads = limit;
+  atomic<unsigned int> next(0);
+  vector<thread> workers;
+  auto work = [&]() {
+    unsigned int j;
+    while((j = next++) < n)
+      join_table(jobs[j], vertices, ev, male, female);
+  };
+
+  if(n_threads > n) n_threads = n;
+  if(n_threads < 2) {
+    work();
+    return;
+  }
+  for(k = 0; k < n_threads; k++)
+    workers.push_back(thread(work));
+  for(k = 0; k < n_threads; k++)
+    workers[k].join();
+}
+
+/*
+ * Match every vertex against the name index of a table in one pass and
+ * copy the visual attributes of the matching rows. If a name occurs on
+ * several rows, the last one in the file wins.
+ */
+static void
+join_table(ImportJob& job, vector<Vertex>& vertices, vector<Emblem>& ev,
+	   char male, char female) {
+  unsigned int i, k;
+  double value;
+  Table& t = *(job.table);
+  ColumnIndex names = t.index(job.name_var);
+
+  job.hits.resize(vertices.size());
+  for(i = 0; i < vertices.size(); i++) {
+    int ind = names.find(Name::text(vertices[i].name));
+    RowView r = t.view(ind);
+    job.hits[i] = -1;
+    if(r.size() < 1) continue;
+    job.hits[i] = ind;
+
+    /* Subgraph name. */
+    if(job.subgraph_var >= 0) 
+      vertices[i].family_name = string(r[job.subgraph_var]);
+      
+    /* Visual features. */
+    if(job.arrow_var >= 0) ev[i].arrow = (r.number(job.arrow_var) > 0.0);
+    if(r[job.color_var].length() > 0) 
+      ev[i].color = (unsigned int)(r.number(job.color_var));
+    if((value = r.number(job.pattern_var)) > 0.0) 
+      ev[i].pattern = (unsigned int)value;
+    if(job.slash_var >= 0) ev[i].slash = (r.number(job.slash_var) > 0.0);
+    if(job.tracer_var >= 0) ev[i].tracer = (r.number(job.tracer_var) > 0.0);
+
+    /* Symbol shape. */
+    if(r[job.gender_var].length() > 0) {
+      if(r[job.gender_var][0] == male) ev[i].shape = 7;
+      if(r[job.gender_var][0] == female) ev[i].shape = 1;
+    }
+    if((value = r.number(job.shape_var)) > 0.0)
+      ev[i].shape = (unsigned int)value;
+ 
+    /* Text info. */
+    for(k = 0; k < job.text_vars.size(); k++) {
+      if(job.text_vars[k] < 0) continue;
+      ev[i].text[k] = string(r[job.text_vars[k]]);
+    }
+  }
+}
+
 /*
  *
  */
 static void
-check_shape(Emblem& emb, string& name, char gender) {
+check_shape(Emblem& emb, unsigned int name, char gender) {
   if(emb.shape == 4) {
     if(gender == 'M') emb.shape = 7;
     if(gender == 'F') emb.shape = 1;
     return;
   }
   if((emb.shape == 1) && (gender == 'M')) {
-    fprintf(stderr, "WARNING! Member '%s' should be male.\n", name.c_str());
+    fprintf(stderr, "WARNING! Member '%s' should be male.\n",
+	    Name::text(name).c_str());
     emb.shape = 4;
     return;
   }
   if((emb.shape == 7) && (gender == 'F')) {
-    fprintf(stderr, "WARNING! Member '%s' should be female.\n", name.c_str());
+    fprintf(stderr, "WARNING! Member '%s' should be female.\n",
+	    Name::text(name).c_str());
     emb.shape = 4;
     return;
   }
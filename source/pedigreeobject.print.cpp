@@ -44,7 +44,7 @@ void
 PedigreeObject::print() {
   int i;
   int page = 1;
-  int figure_limit = (int)(cfg["FigureLimit"].number(1));
+  int figure_limit = (int)(cfg.number("FigureLimit", 1));
   float w = 0.0;
   float h = 0.0;
   map<string, Family>::iterator pos;
@@ -312,8 +312,8 @@ print_topology(FILE* output, Family& family, int ind) {
     n += fprintf(output, "%d_%d", ind, nodes[i].index);
     n += fprintf(output, "\t%s", fam_name.c_str());
     n += fprintf(output, "\t%d_%d", ind, nodes[i].tree);
-    n += fprintf(output, "\t%s", (nodes[i].alpha).c_str());
-    n += fprintf(output, "\t%s", (nodes[i].beta).c_str());
+    n += fprintf(output, "\t%s", Name::text(nodes[i].alpha).c_str());
+    n += fprintf(output, "\t%s", Name::text(nodes[i].beta).c_str());
     n += fprintf(output, "\t%7.2f", nodes[i].x_a);
     n += fprintf(output, "\t%7.2f", nodes[i].x_b);
     n += fprintf(output, "\t%7.2f", nodes[i].y);
@@ -43,6 +43,7 @@ void
 PedigreeObject::print_links(PostScript& ps, Family& family) {
   unsigned int i, k, j, ind;
   vector<Node> nodes = family.nodes();
+  RNG rng((int)(cfg.number("RandomSeed", 1)), family.name());
   Emblem emb_null;
   char buffer[1024];
 
@@ -52,7 +53,7 @@ PedigreeObject::print_links(PostScript& ps, Family& family) {
   for(i = 0; i < nodes.size(); i++)
     order[i] = i;
   for(i = 0; i < nodes.size(); i++) {
-    k = rand()%(nodes.size());
+    k = rng.next()%(nodes.size());
     ind = order[k];
     order[k] = order[i];
     order[i] = ind;
@@ -99,8 +100,8 @@ PedigreeObject::print_links(PostScript& ps, Family& family) {
     if(nodes[i].origin_a == false) continue;
 
     float hue = 1.0*(nodes[i].tree)/n_trees;
-    string& alpha = nodes[i].alpha;
-    string& beta = nodes[i].beta;
+    unsigned int alpha = nodes[i].alpha;
+    unsigned int beta = nodes[i].beta;
     vector<int>& links = nodes[i].links;
     for(k = 0; k < links.size(); k++) {
       j = links[k];
@@ -49,14 +49,14 @@ PedigreeObject::print_nodes(PostScript& ps, Family& family) {
   /* Draw nodes. */
   ps.append("COUR_BOLD\n");
   for(i = 0; i < nodes.size(); i++) {
-    string& key_a = nodes[i].alpha;
-    string& key_b = nodes[i].beta;
-    if(key_a != "") {
+    unsigned int key_a = nodes[i].alpha;
+    unsigned int key_b = nodes[i].beta;
+    if(key_a != 0) {
       Emblem& emb = emblems[key_a];
       draw_emblem(ps, emb, nodes[i].x_a, nodes[i].y);
       draw_text(ps, emb.text, nodes[i].x_a, nodes[i].y, font_width);
     }
-    if(key_b != "") {
+    if(key_b != 0) {
       Emblem& emb = emblems[key_b];
       draw_emblem(ps, emb, nodes[i].x_b, nodes[i].y);
       draw_text(ps, emb.text, nodes[i].x_b, nodes[i].y, font_width);
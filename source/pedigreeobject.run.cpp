@@ -33,38 +33,168 @@
 
 #include "pedigreeobject.h"
 
+#define MIN_GRACE 0.05
+
+/*
+ * Layout task for one family. The results are printed by the main thread
+ * in family order after the pool has finished.
+ */
+struct LayoutJob {
+  Family* family;
+  float share;
+  unsigned int n_iter;
+  double seconds;
+};
+
+class CompareJobs {
+private:
+  vector<LayoutJob>* jobs;
+public:
+  CompareJobs(vector<LayoutJob>* v) {jobs = v;};
+  bool operator()(const unsigned int i1, const unsigned int i2) const {
+    Family* f1 = (*jobs)[i1].family;
+    Family* f2 = (*jobs)[i2].family;
+    return (f1->size() > f2->size());
+  };
+};
+
 /*
- *
+ * Run family layouts on a pool of worker threads. The largest families
+ * are started first and idle workers take the next unstarted family, so
+ * that the pool finishes close to the same time. The time limit is a
+ * wall-clock budget for the whole pool: each family gets its share of the
+ * combined thread time, but never more than what is left of the budget.
+ * Families that start after the budget is spent still get the time they
+ * would have had on a single thread, so that none is skipped.
+ * With several annealing chains per family, the chains of one family run
+ * in parallel and fewer families are processed at the same time.
  */
 bool
 PedigreeObject::run() {
-  int seed = (int)(cfg["RandomSeed"].number(1));
+  unsigned int k;
+  int seed = (int)(cfg.number("RandomSeed", 1));
   time_t start = time(NULL);
-  float time_limit = (float)(cfg["TimeLimit"].number(1));
+  float time_limit = (float)(cfg.number("TimeLimit", 1));
+  unsigned int n_chains = 1;
+  unsigned int n_workers = n_threads;
   map<string, Family>::iterator pos;
 
   if(emblems.size() < 1) return false;
   if(families.size() < 1) return false;
+
+  /* Threads are divided between families and the annealing chains
+     within a family. */
+  if(cfg.number("AnnealingChains", 1) >= 1.0)
+    n_chains = (unsigned int)(cfg.number("AnnealingChains", 1));
+  unsigned int n_inner = min(n_chains, n_threads);
+  n_workers = n_threads/n_inner;
+  if(n_workers > families.size()) n_workers = families.size();
+  if(n_workers < 1) n_workers = 1;
   if(cfg["TimeLimit"].size() < 1)
-    time_limit = 5.0*(families.size());
+    time_limit = 5.0*(families.size())/n_workers;
 
-  if(verbose_mode) cout << "\nComputing layout:\n";
+  /* Annealing schedule. */
+  Schedule schedule;
+  string mode = cfg["AnnealingMode"][1];
+  schedule.mode = TIME_SCHEDULE;
+  schedule.iterations = 0;
+  schedule.epsilon = 1e-3;
+  schedule.window = 100;
+  schedule.repulsion = 0.0;
+  schedule.chains = n_chains;
+  schedule.threads = n_inner;
+  if(cfg.number("RepulsionRange", 1) > 0.0)
+    schedule.repulsion = cfg.number("RepulsionRange", 1);
+  if(mode == "iterations") {
+    schedule.mode = ITERATION_SCHEDULE;
+    schedule.iterations = (unsigned int)(cfg.number("AnnealingMode", 2));
+  }
+  if(mode == "convergence") {
+    schedule.mode = CONVERGENCE_SCHEDULE;
+    if(cfg.number("AnnealingMode", 2) >= 0.0)
+      schedule.epsilon = cfg.number("AnnealingMode", 2);
+    if(cfg.number("AnnealingMode", 3) >= 1.0)
+      schedule.window = (unsigned int)(cfg.number("AnnealingMode", 3));
+  }
+
+  /* Largest families first. */
+  vector<LayoutJob> jobs;
+  vector<unsigned int> order;
   for(pos = families.begin(); pos != families.end(); pos++) {
-    Family& fam = pos->second;
-    time_t now = time(NULL);
-    float grace = time_limit*(fam.size())/(emblems.size());
-    unsigned int n = fam.simulate(grace, seed, verbose_mode);
-    if(verbose_mode) { 
-      if(n > 0)
-	cout << '\t' << fam.name() << '\t' << n << '\t' 
-	     << "iterations in " << difftime(time(NULL), now) << "s\n";
+    LayoutJob job;
+    job.family = &(pos->second);
+    job.share = n_workers*time_limit*(job.family->size())/(emblems.size());
+    job.n_iter = 0;
+    job.seconds = 0.0;
+    order.push_back(jobs.size());
+    jobs.push_back(job);
+  }
+  stable_sort(order.begin(), order.end(), CompareJobs(&jobs));
+
+  /* Run the pool. */
+  if(verbose_mode) cout << "\nComputing layout:\n";
+  bool spinner = (verbose_mode && (n_workers < 2));
+  chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+  atomic<unsigned int> next(0);
+  atomic<unsigned int> n_done(0);
+  auto work = [&]() {
+    unsigned int j;
+    while((j = next++) < order.size()) {
+      LayoutJob& job = jobs[order[j]];
+      chrono::steady_clock::time_point t = chrono::steady_clock::now();
+      chrono::duration<double> dt = (t - t0);
+      float grace = job.share;
+      float left = (time_limit - dt.count());
+      if((seed <= 0) && (grace > left))
+	grace = max(left, (job.share)/n_workers);
+      if(grace < MIN_GRACE) grace = MIN_GRACE;
+      job.n_iter = (job.family)->simulate(grace, seed, spinner, schedule);
+      dt = (chrono::steady_clock::now() - t);
+      job.seconds = dt.count();
+      n_done++;
+    }
+  };
+  if(n_workers < 2) work();
+  else {
+    vector<thread> workers;
+    for(k = 0; k < n_workers; k++)
+      workers.push_back(thread(work));
+
+    /* Aggregated progress monitor. */
+    unsigned int counter = 0;
+    unsigned int ticks = 0;
+    bool printed = false;
+    while(verbose_mode && (n_done < order.size())) {
+      this_thread::sleep_for(chrono::milliseconds(50));
+      if((++ticks)%10 != 0) continue;
+      if(n_done >= order.size()) break;
+      chrono::duration<double> dt = (chrono::steady_clock::now() - t0);
+      printf("\r%c\t%u/%u families\t%u threads\t%.0fs ", "|/-\\"[counter],
+	     (unsigned int)n_done, (unsigned int)(order.size()),
+	     n_workers*n_inner, dt.count());
+      fflush(stdout);
+      counter = (counter + 1)%4;
+      printed = true;
+    }
+    if(printed) printf("\r%80s\r", "");
+    for(k = 0; k < n_workers; k++)
+      workers[k].join();
+  }
+
+  /* Report in family order. */
+  if(verbose_mode) {
+    unsigned long n_total = 0;
+    for(k = 0; k < jobs.size(); k++) {
+      n_total += jobs[k].n_iter;
+      if(jobs[k].n_iter > 0)
+	cout << '\t' << (jobs[k].family)->name() << '\t' << jobs[k].n_iter
+	     << '\t' << "iterations in " << (int)(jobs[k].seconds) << "s\n";
       else
 	cout << "\t...\n";
     }
-  } 
-  if(verbose_mode) { 
     cout << "\tLayout computed in "
-	 << difftime(time(NULL), start) << "s.\n";
+	 << difftime(time(NULL), start) << "s (" << n_total
+	 << " iterations).\n";
   }
 
   return true;
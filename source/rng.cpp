@@ -0,0 +1,82 @@
+/* file: rng.cpp
+  Copyright (C) 2008 Ville-Petteri Makinen
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the
+  Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+  CITATION (if not provided by software website)
+    Makinen V-P, software name, URL:http://www.iki.fi/~vpmakine/
+
+  CONTACT (if not provided by citation)
+    Ville-Petteri Makinen
+ 
+    Folkhalsan Research Center
+    Biomedicum Helsinki P.O.Box 63
+    Haartmaninkatu 8 00014, Helsinki, Finland
+    Tel: +358 9 191 25462
+    Fax: +358 9 191 25452
+
+    WWW:   http://www.iki.fi/~vpmakine
+*/
+
+#include <time.h>
+#include "rng.h"
+
+using namespace std;
+
+static uint64_t mix(uint64_t);
+
+/*
+ *
+ */
+RNG::RNG() {
+  state = 0x853c49e6748fea9bULL;
+  increment = 0xda3e39cb94b95bdbULL;
+}
+
+/*
+ * Seed from a user seed and a name. Non-positive seeds are replaced by
+ * the current time as with srand().
+ */
+RNG::RNG(const int seed, const string& name) {
+  unsigned int i;
+  uint64_t h = 0xcbf29ce484222325ULL;
+  uint64_t s = (uint64_t)seed;
+  if(seed <= 0) s = (uint64_t)time(NULL);
+
+  /* FNV-1a hash of the name. */
+  for(i = 0; i < name.length(); i++) {
+    h ^= (unsigned char)(name[i]);
+    h *= 0x100000001b3ULL;
+  }
+
+  /* Standard PCG initialization. */
+  state = 0;
+  increment = ((mix(h) << 1) | 1);
+  next();
+  state += mix(s ^ h);
+  next();
+}
+
+/*
+ * SplitMix64 finalizer.
+ */
+static uint64_t
+mix(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = ((x ^ (x >> 30))*0xbf58476d1ce4e5b9ULL);
+  x = ((x ^ (x >> 27))*0x94d049bb133111ebULL);
+  return (x ^ (x >> 31));
+}
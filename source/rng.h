@@ -0,0 +1,64 @@
+/* file: rng.h
+  Copyright (C) 2008 Ville-Petteri Makinen
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the
+  Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+  CITATION (if not provided by software website)
+    Makinen V-P, software name, URL:http://www.iki.fi/~vpmakine/
+
+  CONTACT (if not provided by citation)
+    Ville-Petteri Makinen
+ 
+    Folkhalsan Research Center
+    Biomedicum Helsinki P.O.Box 63
+    Haartmaninkatu 8 00014, Helsinki, Finland
+    Tel: +358 9 191 25462
+    Fax: +358 9 191 25452
+
+    WWW:   http://www.iki.fi/~vpmakine
+*/
+
+#ifndef rng_INCLUDED
+#define rng_INCLUDED
+
+#include <string>
+#include <stdint.h>
+
+/*
+ * Small reentrant pseudo-random number generator (PCG32). Every family
+ * owns one, so that its layout depends only on the random seed and the
+ * family name, not on the order or thread the family is processed in.
+ */
+class RNG {
+private:
+  uint64_t state;
+  uint64_t increment;
+public:
+  RNG();
+  RNG(const int, const std::string&);
+  unsigned int next() {
+    uint64_t old = state;
+    state = (old*6364136223846793005ULL + increment);
+    uint32_t bits = (uint32_t)(((old >> 18) ^ old) >> 27);
+    uint32_t rot = (uint32_t)(old >> 59);
+    return ((bits >> rot) | (bits << ((32 - rot) & 31)));
+  };
+  float uniform() {
+    return (next() >> 8)*(1.0f/16777216.0f);
+  };
+};
+
+#endif /* rng_INCLUDED */
@@ -67,11 +67,11 @@ Row::operator[](const int j) const {
 /*
  *
  */
-unsigned int
+size_t
 Row::mem_size() const {
   int info[3];
   get_info(info, buffer);
-  return info[RSIZE_ind];
+  return (size_t)(info[RSIZE_ind]);
 }
 
 /*
@@ -79,28 +79,8 @@ Row::mem_size() const {
  */
 double
 Row::number(const int j) const {
-  unsigned int i, n;
   string s = get_data(buffer, j);
-
-  /* Replace commas. */
-  n = s.size();
-  for(i = 0; i < n; i++)
-    if(s[i] == ',') s[i] = '.';
-
-  /* Parse value. */
-  double value = atof(s.c_str());
-  if(value != 0.0) return value;
-
-  /* Check if illegible. */
-  bool flag = false;
-  for(i = 0; i < n; i++) {
-    if(!flag && isspace(s[i])) continue;
-    if(flag && isspace(s[i])) return nan();
-    if(flag && (s[i] == '.')) return nan();
-    if(s[i] == '0') return value;
-    flag = true;
-  }
-  return nan();
+  return field2number(s.c_str(), s.size());
 }
 
 /*
@@ -146,7 +126,7 @@ RowObject::fill(const void* ptr_row) {
   unsigned int pos = 0;
   int info[3];
   char* ptr;
-  char* field;
+  field_t* field;
   row_t* row = (row_t*)ptr_row;
   if(row == NULL) return;
 
@@ -160,19 +140,21 @@ RowObject::fill(const void* ptr_row) {
 
   /* Copy field addresses. Note that the position in the
      block array is stored, not including the buffer offset. */
-  field = row->line;
   for(k = 0; k < row->n_fields; k++) {
-    pos = (unsigned int)(field - row->line);
     ptr = (char*)(&pos);
     for(i = 0; i < sizeof(int); i++)
       buffer.push_back(ptr[i]);
-    field += (strlen(field) + 1);
+    pos += ((row->fields)[k].length + 1);
   }
 
-  /* Copy row data. */
-  ptr = row->line;
-  for(i = 0; i < row->size; i++)
-    buffer.push_back(ptr[i]);
+  /* Copy row data with null terminated fields. */
+  for(k = 0; k < row->n_fields; k++) {
+    field = (row->fields + k);
+    ptr = (row->line + field->offset);
+    for(i = 0; i < field->length; i++)
+      buffer.push_back(ptr[i]);
+    buffer.push_back('\0');
+  }
 }
 
 /*
@@ -232,7 +214,7 @@ get_info(int* info, const vector<char>& v) {
   info[RANK_ind] = -1;
   info[N_FIELDS_ind] = 0;
   info[RSIZE_ind] = 0;
-  if(v.size() > 3*sizeof(int)) {
+  if(v.size() >= 3*sizeof(int)) {
     ptr = (char*)info;
     for(i = 0; i < 3*sizeof(int); i++)
       ptr[i] = v[i];
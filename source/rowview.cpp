@@ -0,0 +1,99 @@
+/* file: rowview.cpp
+  Copyright (C) 2008 Ville-Petteri Makinen
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the
+  Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+  CITATION (if not provided by software website)
+    Makinen V-P, software name, URL:http://www.iki.fi/~vpmakine/
+
+  CONTACT (if not provided by citation)
+    Ville-Petteri Makinen
+ 
+    Folkhalsan Research Center
+    Biomedicum Helsinki P.O.Box 63
+    Haartmaninkatu 8 00014, Helsinki, Finland
+    Tel: +358 9 191 25462
+    Fax: +358 9 191 25452
+
+    WWW:   http://www.iki.fi/~vpmakine
+*/
+
+#include "table.h"
+
+/*
+ *
+ */
+RowView::RowView() {
+  row = NULL;
+}
+
+/*
+ *
+ */
+string_view
+RowView::operator[](const int j) const {
+  row_t* r = (row_t*)row;
+  if(r == NULL) return string_view();
+  if(j < 0) return string_view();
+  if(j >= r->n_fields) return string_view();
+  return string_view((r->line + r->fields[j].offset), r->fields[j].length);
+}
+
+/*
+ *
+ */
+size_t
+RowView::mem_size() const {
+  row_t* r = (row_t*)row;
+  if(r == NULL) return 0;
+  return (size_t)(r->size);
+}
+
+/*
+ *
+ */
+double
+RowView::number(const int j) const {
+  string_view s = (*this)[j];
+  return field2number(s.data(), s.size());
+}
+
+/*
+ *
+ */
+int
+RowView::rank() const {
+  row_t* r = (row_t*)row;
+  if(r == NULL) return -1;
+  return r->rank;
+}
+
+/*
+ *
+ */
+unsigned int
+RowView::size() const {
+  row_t* r = (row_t*)row;
+  if(r == NULL) return 0;
+  return r->n_fields;
+}
+
+/*
+ *
+ */
+RowViewObject::RowViewObject(const void* ptr) {
+  row = ptr;
+}
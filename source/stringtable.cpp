@@ -49,10 +49,9 @@ StringTable::StringTable(const std::string& text, const char sep) {
   buffer = tb;
   
   /* Prepare buffer. */
-  unsigned int n = text.size();
-  tb->buf = (char*)malloc(n + 2);
-  strcpy(tb->buf, text.c_str());
-  tb->buf[n] = '\n';
-  tb->buf[n+1] = '\0';
-  tb->prepare(sep);
+  size_t n = text.size();
+  tb->buf = (char*)malloc(n + 1);
+  memcpy(tb->buf, text.c_str(), (n + 1));
+  tb->n_bytes = n;
+  tb->prepare(sep, NULL);
 }
@@ -36,8 +36,10 @@
 #define IOBUFCAP 524288
 
 char EmptyChar = '\0';
-static unsigned int ID = 1;
-extern char* read_buffer(FILE*, unsigned int);
+static atomic<unsigned int> ID(1);
+static atomic<bool> Snapshots(false);
+static atomic<unsigned int> Threads(0);
+extern char* read_buffer(FILE*, unsigned int, size_t*);
 
 /*
  *
@@ -60,21 +62,17 @@ Table::Table(const Table& t) {
  *
  */
 Table::Table(const string& fname, const char sep) {
+  buffer = new TableBuffer(ID++);
+  load(fname, sep, NULL);
+}
 
-  /* Default state. */
-  TableBuffer* tb = new TableBuffer(ID++);
-  tb->data_source = (char*)malloc(fname.length() + 1);
-  strcpy(tb->data_source, fname.c_str());
-  buffer = tb;
-
-  /* Import data. */
-  FILE* input = fopen(fname.c_str(), "r");
-  if(input == NULL) return;
-
-  /* Prepare buffer. */
-  tb->buf = read_buffer(input, IOBUFCAP);
-  tb->prepare(sep);
-  fclose(input);
+/*
+ *
+ */
+Table::Table(const string& fname, const char sep,
+	     const vector<string>& headings) {
+  buffer = new TableBuffer(ID++);
+  load(fname, sep, &headings);
 }
 
 /*
@@ -105,6 +103,65 @@ Table::strcmp(const string& s1, const string& s2) {
   return 0;
 }
 
+/*
+ *
+ */
+void
+Table::load(const string& fname, const char sep,
+	    const vector<string>* headings) {
+  TableBuffer* tb = (TableBuffer*)buffer;
+  tb->data_source = (char*)malloc(fname.length() + 1);
+  strcpy(tb->data_source, fname.c_str());
+  tb->n_threads = Threads;
+  if(tb->n_threads < 1) tb->n_threads = thread::hardware_concurrency();
+
+  /* Import data. Regular files are mapped, other sources are read
+     to a private buffer. */
+  if(!tb->map(fname.c_str())) {
+    FILE* input = fopen(fname.c_str(), "r");
+    if(input == NULL) return;
+    tb->buf = read_buffer(input, IOBUFCAP, &(tb->n_bytes));
+    fclose(input);
+  }
+  else if(Snapshots) {
+    uint64_t key;
+    string s(1, sep);
+
+    /* The key identifies the separator and the projection. */
+    if(headings != NULL) {
+      s += '*';
+      for(unsigned int i = 0; i < headings->size(); i++)
+	s += ((*headings)[i] + '\0');
+    }
+    key = data2code(s.c_str(), s.size());
+
+    /* Reuse a valid snapshot or replace a stale one. */
+    if(tb->restore(fname.c_str(), key)) return;
+    tb->prepare(sep, headings);
+    tb->store(fname.c_str(), key);
+    return;
+  }
+
+  /* Prepare buffer. */
+  tb->prepare(sep, headings);
+}
+
+/*
+ *
+ */
+void
+Table::snapshots(const bool flag) {
+  Snapshots = flag;
+}
+
+/*
+ *
+ */
+void
+Table::threads(const unsigned int n) {
+  Threads = n;
+}
+
 /*
  *
  */
@@ -33,33 +33,27 @@
 
 #include "table.h"
 
+static int keycmp(const row_t*, const int*, const vector<sortkey_t>&);
+
 /*
  *
  */
 int
 Table::find(const string& keyword, const int column) const {
-  int n;
-  vector<int> indices;
-  vector<int> columns;
-  vector<string> keywords;
-  columns.push_back(column);
-  keywords.push_back(keyword);
-  indices = find(keywords, columns);
-  n = indices.size();
-  if(n < 1) return -1;
-  return indices[n-1];
+  return index(column).find(keyword);
 }
 
 /*
- *
+ * The table must be sorted so that the given columns are the leading
+ * keys. Matching rows are returned in the original order.
  */
 vector<int>
 Table::find(const vector<string>& keywords,
 		  const vector<int>& columns) const {
-  int i, k, n;
-  row_t rkey[1];
-  row_t* hit;
+  int i, j, k, n;
+  int lo, hi, mid;
   vector<int> indices(0);
+  vector<sortkey_t> proto;
   TableBuffer* tb = (TableBuffer*)buffer;
 
   n = keywords.size();
@@ -74,52 +68,51 @@ Table::find(const vector<string>& keywords,
   for(i = 0, k = 0; i < n; i++) {
     if(columns[i] < 0) continue;
     if(columns[i] >= tb->n_cols) continue;
-    if((tb->keycols[k] != columns[i]) || (tb->keycols[k] < 0)) {
+    if((k >= tb->n_keys) || (tb->keycols[k] != columns[i])) {
       cerr << "WARNING! " << __FILE__
 	   <<  ": Table is not sorted correctly.\n";
       return indices;
     }
+    proto.push_back(sortkey_t());
+    field2key(&(proto[k]), keywords[i].c_str(), keywords[i].size());
     k++;
   }
 
-  /* Create prototype row. */
-  rkey->rank = -1;
-  rkey->size = 0;
-  rkey->n_keys = n;
-  rkey->n_fields = 1;
-  rkey->key_0 = NULL;
-  rkey->key_1 = NULL;
-  rkey->key_2 = NULL;
-  rkey->key_3 = NULL;
-  rkey->line = &EmptyChar;
-  rkey->keycols = tb->keycols;
-
-  /* Make key shortcuts. */
-  if(n > 0) rkey->key_0 = (char*)(keywords[0].c_str());
-  if(n > 1) rkey->key_1 = (char*)(keywords[1].c_str());
-  if(n > 2) rkey->key_2 = (char*)(keywords[2].c_str());
-  if(n > 3) rkey->key_3 = (char*)(keywords[3].c_str());
-  if(n > 4) {
-    cerr << "ERROR! " << __FILE__ << " at line " << __LINE__
-	 << ": Max 4 keys supported.\n";
-    exit(1);
-  };
-
-  /* Find a matching row. */
-  hit = (row_t*)bsearch(rkey, tb->rows, tb->n_rows, sizeof(row_t), &rowcmp);
-  if(hit == NULL) return indices;
-
-  /* Find all matching rows. */
-  n = 0;
-  k = (int)(hit - tb->rows);
-  for(i = (k - 1); i >= 0; i--) {
-    if(rowcmp((tb->rows + i), rkey) == 0) k = i;
-    else break;
+  /* Find the first matching row. */
+  lo = 0;
+  hi = tb->n_rows;
+  while(lo < hi) {
+    mid = (lo + (hi - lo)/2);
+    if(keycmp(tb->rows + mid, tb->keycols, proto) < 0) lo = (mid + 1);
+    else hi = mid;
   }
-  for(i = k; i < tb->n_rows; i++) {
-    if(rowcmp((tb->rows + i), rkey) == 0) indices.push_back(i);
-    else break;
+
+  /* Collect all matching rows. */
+  for(j = lo; j < tb->n_rows; j++) {
+    if(keycmp(tb->rows + j, tb->keycols, proto) != 0) break;
+    indices.push_back(j);
   }
 
   return indices;
 }
+
+/*
+ * Compare the leading keys of a row against a prototype.
+ */
+static int
+keycmp(const row_t* row, const int* keycols, const vector<sortkey_t>& proto) {
+  int j, k;
+  sortkey_t key;
+  field_t* f;
+  for(j = 0; j < (int)(proto.size()); j++) {
+    k = keycols[j];
+    if(k >= row->n_fields)
+      field2key(&key, NULL, 0);
+    else {
+      f = (row->fields + k);
+      field2key(&key, (row->line + f->offset), f->length);
+    }
+    if((k = keycmp(&key, &(proto[j]))) != 0) return k;
+  }
+  return 0;
+}
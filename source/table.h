@@ -37,30 +37,57 @@
 #include <iostream>
 #include <algorithm>
 #include <limits>
+#include <functional>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <unordered_map>
 #include <stdlib.h>
 #include <stdio.h>
 #include <ctype.h>
 #include <string.h>
 #include <limits.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
 #include "tablet.h"
 
 #define VERSION    "1.3.3"
-#define BUF_LIMIT  67108864
 
 using namespace std;
 using namespace tablet;
 
+typedef struct {
+  unsigned int offset;
+  unsigned int length;
+} field_t;
+
+typedef struct {
+  int column;
+  unsigned int mask;
+  int* heads;
+  int* chain;
+  unsigned int* codes;
+} hash_t;
+
+typedef struct {
+  float value;
+  unsigned int length;
+  uint64_t prefix;
+  const char* ptr;
+} sortkey_t;
+
 typedef struct {
   int rank;
-  int n_keys;
   int n_fields;
-  unsigned int size;
-  char* key_0;
-  char* key_1;
-  char* key_2;
-  char* key_3;
+  size_t size;
   char* line;
-  int* keycols;
+  field_t* fields;
 } row_t;
 
 class RowObject: public Row {
@@ -69,43 +96,134 @@ public:
   void fill(const void*);
 };
 
+class RowViewObject: public RowView {
+public:
+  RowViewObject(const void*);
+};
+
+class ColumnIndexObject: public ColumnIndex {
+public:
+  ColumnIndexObject(void*, void*);
+};
+
+typedef struct {
+  int top;
+  vector<Row> rows;
+  vector<vector<double> > numbers;
+} entry_t;
+
+typedef unordered_map<string, entry_t> dictionary_t;
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t header_size;
+  uint64_t source_size;
+  int64_t source_mtime;
+  uint64_t source_code;
+  uint64_t snapshot_code;
+  uint64_t key;
+  int32_t n_rows;
+  int32_t n_cols;
+  uint64_t n_fields;
+  uint64_t data_offset;
+  uint64_t data_size;
+  uint64_t rows_offset;
+  uint64_t fields_offset;
+  uint64_t origins_offset;
+  int32_t n_origins;
+  char separator;
+} snapshot_t;
+
+typedef struct {
+  int32_t rank;
+  int32_t n_fields;
+  uint64_t size;
+  uint64_t line;
+  uint64_t first_field;
+} snaprow_t;
+
 class TableBuffer {
 public:
+  bool shared_fields;
   char separator;
   int n_rows;
   int n_cols;
+  int n_keys;
   unsigned int id_code;
-  unsigned int buf_size;
+  unsigned int n_threads;
+  size_t buf_size;
+  size_t n_bytes;
+  size_t map_size;
+  uint64_t checksum;
   char* buf;
   int* keycols;
   int* rank2locus;
+  int* origins;
   row_t* rows;
+  field_t* fields;
+  hash_t** hashes;
+  dictionary_t* dictionary;
   char* data_source;
+  mutex hash_lock;
 public:
   TableBuffer(unsigned int id) {
+    shared_fields = false;
     separator = '\0';
     id_code = id;
+    n_threads = 1;
     n_rows = 0;
     n_cols = 0;
+    n_keys = 0;
     buf_size = 0;
+    n_bytes = 0;
+    map_size = 0;
+    checksum = 0;
     buf = NULL;
     data_source = NULL;
     keycols = NULL;
     rank2locus = NULL;
+    origins = NULL;
     rows = NULL;
+    fields = NULL;
+    hashes = NULL;
+    dictionary = NULL;
   };
   ~TableBuffer() {
-    if(buf != NULL) free(buf);
+    release();
     if(keycols != NULL) free(keycols);
     if(rank2locus != NULL) free(rank2locus);
+    if(origins != NULL) free(origins);
     if(rows != NULL) free(rows);
+    if((fields != NULL) && !shared_fields) free(fields);
     if(data_source != NULL) free(data_source);
+    if(dictionary != NULL) delete dictionary;
+    if(hashes != NULL) {
+      for(int i = 0; i < n_cols; i++) {
+	if(hashes[i] == NULL) continue;
+	free(hashes[i]->heads);
+	free(hashes[i]->chain);
+	free(hashes[i]->codes);
+	free(hashes[i]);
+      }
+      free(hashes);
+    }
   };
-  void prepare(const char);
+  hash_t* hash(const int);
+  int lookup(const hash_t*, const char*, size_t) const;
+  bool map(const char*);
+  bool restore(const char*, uint64_t);
+  void store(const char*, uint64_t);
+  void prepare(const char, const vector<string>*);
+  void release();
 };
 
 extern char EmptyChar;
-extern int  rowcmp(const void*, const void*);
+extern int    keycmp(const sortkey_t*, const sortkey_t*);
+extern void   field2key(sortkey_t*, const char*, size_t);
+extern double field2number(const char*, size_t);
+extern unsigned int field2code(const char*, size_t);
+extern uint64_t data2code(const char*, size_t);
 
 #endif /* table_INCLUDED */
 
@@ -33,6 +33,38 @@
 
 #include "table.h"
 
+typedef struct {
+  sortkey_t key;
+  int index;
+} sortrec_t;
+
+class CompareKeys {
+private:
+  int n_keys;
+  const sortkey_t* keys;
+  const row_t* rows;
+public:
+  CompareKeys(const sortkey_t* k, const row_t* r, const int n) {
+    n_keys = n;
+    keys = k;
+    rows = r;
+  };
+  bool operator()(const sortrec_t& r1, const sortrec_t& r2) const {
+    int j, k;
+    const sortkey_t* k1;
+    const sortkey_t* k2;
+    if((k = keycmp(&(r1.key), &(r2.key))) != 0) return (k < 0);
+
+    /* Secondary keys. */
+    k1 = (keys + (size_t)(r1.index)*n_keys);
+    k2 = (keys + (size_t)(r2.index)*n_keys);
+    for(j = 1; j < n_keys; j++) {
+      if((k = keycmp((k1 + j), (k2 + j))) != 0) return (k < 0);
+    }
+    return (rows[r1.index].rank < rows[r2.index].rank);
+  };
+};
+
 /*
  * Sort using every column. 
  */
@@ -47,55 +79,77 @@ Table::sort() {
 };
 
 /*
- * Column indices start from 0 as in C-style.
+ * Column indices start from 0 as in C-style. Each key field is parsed
+ * once, rows with equal keys remain in the original order.
  */
 void
 Table::sort(const vector<int>& cols) {
   int i, j, k;
   int n = cols.size();
-  int cap = (n + 5);
-  char* ptr;
+  int n_rows;
+  field_t* f;
+  row_t* rows;
+  row_t* sorted;
+  sortkey_t* keys;
+  sortkey_t* key;
+  vector<sortrec_t> order;
   TableBuffer* tb = (TableBuffer*)buffer;
-  int* keycols = tb->keycols;
-  row_t* rows = tb->rows;
-
-  /* Reset keycols and rows. */
-  tb->keycols = (int*)realloc(tb->keycols, cap*sizeof(int));
-  keycols = tb->keycols;
-  for(i = 0; i < cap; i++)
-    keycols[i] = -1;
-  for(i = 0; i < tb->n_rows; i++) {
-    rows[i].n_keys = n;
-    rows[i].key_0 = NULL;
-    rows[i].key_1 = NULL;
-    rows[i].key_2 = NULL;
-    rows[i].key_3 = NULL;
-    rows[i].keycols = keycols;
-  }
 
   /* Copy valid column indices. */
+  tb->keycols = (int*)realloc(tb->keycols, (n + 1)*sizeof(int));
   for(i = 0, k = 0; i < n; i++) {
     if(cols[i] < 0) continue;
     if(cols[i] >= tb->n_cols) continue;
-    keycols[k++] = cols[i];
+    tb->keycols[k++] = cols[i];
   }
+  tb->keycols[k] = -1;
+  tb->n_keys = k;
+  n = k;
 
-  /* Update keys. */
-  for(i = 0; i < tb->n_rows; i++) {
-    n = rows[i].n_fields;
-    ptr = rows[i].line;
-    for(j = 0; j < n; j++) {
-      if(j == keycols[0]) rows[i].key_0 = ptr;
-      if(j == keycols[1]) rows[i].key_1 = ptr;
-      if(j == keycols[2]) rows[i].key_2 = ptr;
-      if(j == keycols[3]) rows[i].key_3 = ptr;
-      ptr += (strlen(ptr) + 1);
+  /* Parse keys. */
+  rows = tb->rows;
+  n_rows = tb->n_rows;
+  if(n_rows < 1) return;
+  keys = (sortkey_t*)malloc(((size_t)n_rows*n + 1)*sizeof(sortkey_t));
+  if(keys == NULL) {
+    fprintf(stderr, "ERROR! %s at line %d: Out of memory.\n",
+	    __FILE__, __LINE__);
+    exit(1);
+  }
+  for(i = 0, key = keys; i < n_rows; i++) {
+    for(j = 0; j < n; j++, key++) {
+      k = tb->keycols[j];
+      if(k >= rows[i].n_fields) {
+	field2key(key, NULL, 0);
+	continue;
+      }
+      f = (rows[i].fields + k);
+      field2key(key, (rows[i].line + f->offset), f->length);
     }
   }
 
-  /* Sort rows. */
-  qsort(rows, tb->n_rows, sizeof(row_t), &rowcmp);
-  for(i = 0; i < tb->n_rows; i++) {
+  /* Sort row indices, the primary key is kept inline. */
+  order.resize(n_rows);
+  for(i = 0; i < n_rows; i++) {
+    order[i].index = i;
+    if(n > 0) order[i].key = keys[(size_t)i*n];
+    else field2key(&(order[i].key), NULL, 0);
+  }
+  std::sort(order.begin(), order.end(), CompareKeys(keys, rows, n));
+  free(keys);
+
+  /* Permute rows in place. */
+  sorted = (row_t*)malloc(n_rows*sizeof(row_t));
+  if(sorted == NULL) {
+    fprintf(stderr, "ERROR! %s at line %d: Out of memory.\n",
+	    __FILE__, __LINE__);
+    exit(1);
+  }
+  for(i = 0; i < n_rows; i++)
+    sorted[i] = rows[order[i].index];
+  memcpy(rows, sorted, n_rows*sizeof(row_t));
+  free(sorted);
+  for(i = 0; i < n_rows; i++) {
     k = rows[i].rank;
     tb->rank2locus[k] = i;
   }
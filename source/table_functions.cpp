@@ -33,303 +33,189 @@
 
 #include "table.h"
 
-static unsigned int trim_line(char*);
-
 /*
  *  Read the contents of the stream and append a linebreak
- *  and terminating null character to the buffer.
+ *  and terminating null character to the buffer. The number of
+ *  bytes read is stored in the last argument. The whole stream is
+ *  read, failure to do so is a fatal error.
  */
 char*
-read_buffer(FILE* input, unsigned int iobufcap) {
-  unsigned int size;
-  unsigned int n_read = 0;
-  unsigned int cap = 0;
+read_buffer(FILE* input, unsigned int iobufcap, size_t* n_bytes) {
+  size_t size;
+  size_t n_read = 0;
+  size_t cap = 0;
+  size_t grow = 0;
   char* buf = NULL;
+  char* ptr = NULL;
   if(iobufcap < BUFSIZ) iobufcap = BUFSIZ;
 
   n_read = 0;
-  cap = iobufcap;
-  buf = (char*)malloc(iobufcap + 2);
+  cap = (iobufcap + 2);
+  if((buf = (char*)malloc(cap)) == NULL) {
+    fprintf(stderr, "ERROR! %s at line %d: Out of memory.\n",
+	    __FILE__, __LINE__);
+    exit(1);
+  }
   while((size = fread((buf + n_read), 1, iobufcap, input)) > 0) {
     n_read += size;
-    if((n_read + iobufcap) > BUF_LIMIT) {      
-      fprintf(stderr, "WARNING! %s: Buffer limit exceeded.\n", __FILE__);
-      break;
-    }
-    if((n_read + iobufcap) > cap) {      
-      cap = (3*n_read/2 + iobufcap + 2);
-      buf = (char*)realloc(buf, cap);
+    if((n_read + iobufcap + 2) <= cap) continue;
+    grow = (n_read/2 + iobufcap + 2);
+    ptr = NULL;
+    if(grow <= (SIZE_MAX - n_read))
+      ptr = (char*)realloc(buf, (n_read + grow));
+    if(ptr == NULL) {
+      fprintf(stderr, "ERROR! %s at line %d: Out of memory after %lu "
+	      "bytes.\n", __FILE__, __LINE__, (unsigned long)n_read);
+      exit(1);
     }
+    cap = (n_read + grow);
+    buf = ptr;
+  }
+  if(ferror(input)) {
+    fprintf(stderr, "ERROR! %s at line %d: Read failed after %lu bytes.\n",
+	    __FILE__, __LINE__, (unsigned long)n_read);
+    exit(1);
   }
   buf[n_read] = '\n';
   buf[n_read+1] = '\0';  
+  *n_bytes = (n_read + 1);
 
   return buf;
 }
 
-
 /*
- * Return the trimmed buffer and number of lines.
- * Buffer must be null terminated.
+ * Compare two sort keys, first numerically and then lexicographically.
+ * Missing fields come before any others.
  */
-char*
-trim_buffer(char* buf, int* num) {
-  unsigned int len = 0;
-  unsigned int n_read = 0;
-  unsigned int n_bytes = 0;
-  char* ptr = buf;
-
-  /* Read one line at a time. */
-  *num = 0;
-  while((ptr = strpbrk(ptr, "\r\n")) != NULL) {
-    *ptr = '\0';
-    ptr++;    
-
-    if((len = trim_line(buf + n_read)) < 1) {
-      n_read = (unsigned int)(ptr - buf);
-      continue;
-    }
-    memmove((buf + n_bytes), (buf + n_read), (len + 1));
-
-    (*num)++;
-    n_bytes += (len + 1);
-    n_read = (unsigned int)(ptr - buf);
-  }
-
-  return (char*)realloc(buf, n_bytes);
+int
+keycmp(const sortkey_t* k1, const sortkey_t* k2) {
+  int k;
+  unsigned int n;
+  if(k1->ptr == NULL) return ((k2->ptr == NULL) ? 0 : -1);
+  if(k2->ptr == NULL) return 1;
+  if(k1->value < k2->value) return -1;
+  if(k1->value > k2->value) return 1;
+  if(k1->prefix < k2->prefix) return -1;
+  if(k1->prefix > k2->prefix) return 1;
+  n = k1->length;
+  if(n > k2->length) n = k2->length;
+  if((n > 0) && ((k = memcmp(k1->ptr, k2->ptr, n)) != 0)) return k;
+  if(k1->length < k2->length) return -1;
+  if(k1->length > k2->length) return 1;
+  return 0;
 }
 
 /*
- * Return the tidy buffer and number of lines. Replace all sequences 
- * of linebreaks (newline or carriage return) with a single null
- * character. Empty lines are ignored. Buffer must be null terminated.
+ * Parse a character sequence into a sort key. The numeric value is
+ * interpreted as by atof(), except that NaN is replaced by zero so that
+ * words such as "Nancy" sort among other text. The first eight bytes
+ * are packed into an integer that orders like memcmp(). A missing field
+ * is indicated by a null pointer.
  */
-char*
-tidy_buffer(char* buf, int* num, char sep) {
-  unsigned int i;
-  unsigned int len = 0;
-  unsigned int n_read = 0;
-  unsigned int n_bytes = 0;
-  char* ptr = buf;
-
-  /* Read one line at a time. */
-  *num = 0;
-  while((ptr = strpbrk(ptr, "\r\n")) != NULL) {
-    while((*ptr == '\n') || (*ptr == '\r')) {
-      *ptr = '\0';
-      ptr++;
-    }
-    len = strlen(buf + n_read);
-
-    /* Accept only lines with at least one non-separator. */
-    for(i = n_read; buf[i] != '\0'; i++) {
-      if(buf[i] == sep) continue;
-      memmove((buf + n_bytes), (buf + n_read), (len + 1));
-      n_bytes += (len + 1);
-      *num += 1;
-      break;
-    }
-    n_read = (unsigned int)(ptr - buf);
+void
+field2key(sortkey_t* key, const char* ptr, size_t n) {
+  char buf[64];
+  size_t i;
+  float value = 0.0;
+  key->value = 0.0;
+  key->length = n;
+  key->prefix = 0;
+  key->ptr = ptr;
+  if(ptr == NULL) return;
+  for(i = 0; i < 8; i++) {
+    key->prefix <<= 8;
+    if(i < n) key->prefix |= (unsigned char)(ptr[i]);
   }
 
-  return (char*)realloc(buf, n_bytes);
+  /* Skip sequences that cannot start a number. */
+  for(i = 0; (i < n) && isspace((unsigned char)(ptr[i])); i++);
+  if(i >= n) return;
+  if(ptr[i] == '\0') return;
+  if(strchr("+-.0123456789iInN", ptr[i]) == NULL) return;
+
+  /* Convert to a number. */
+  if(n < sizeof(buf)) {
+    memcpy(buf, ptr, n);
+    buf[n] = '\0';
+    value = atof(buf);
+  }
+  else
+    value = atof(string(ptr, n).c_str());
+  if(value == value) key->value = value;
 }
 
 /*
- *  Input buffer must be trimmed. 
- *  Return the maximum number of tokens per line.
+ * Floating point value of a character sequence. Both the comma ',' and
+ * period '.' are interpreted as the radix point. If the value is
+ * illegible, Row::nan() is returned.
  */
-unsigned int
-finish_buffer(char* buf, row_t* rows, unsigned int n_rows, char sep) {
-  unsigned int i, n;
-  unsigned int n_cols = 0;
-  unsigned int size;
-  char* line;
-  char* ptr;
-
-  /* Find pointer and count the num of tokens for each line. */
-  line = buf;
-  for(i = 0; i < n_rows; i++) {
-    size = (strlen(line) + 1);
-
-    /* Replace separator with '\0'. */
-    ptr = line;
-    for(n = 1; (ptr = strchr(ptr, sep)) != NULL; n++) {
-      *ptr = '\0'; 
-      ptr++;
+double
+field2number(const char* ptr, size_t n) {
+  bool flag = false;
+  char c;
+  char local[64];
+  char* s = local;
+  size_t i;
+  double value;
+
+  /* Replace commas. Short fields do not need heap memory. */
+  if(n >= sizeof(local)) {
+    if((s = (char*)malloc(n + 1)) == NULL) {
+      fprintf(stderr, "ERROR! %s at line %d: Out of memory.\n",
+	      __FILE__, __LINE__);
+      exit(1);
     }
-    if(n > n_cols) n_cols = n;
-
-    rows[i].rank = i;
-    rows[i].size = size;
-    rows[i].n_keys = 0;
-    rows[i].n_fields = n;
-    rows[i].key_0 = NULL;
-    rows[i].key_1 = NULL;
-    rows[i].key_2 = NULL;
-    rows[i].key_3 = NULL;
-    rows[i].line = line;
-    rows[i].keycols = NULL;
-    line += size;
   }
-
-  return n_cols;
+  for(i = 0; i < n; i++) {
+    s[i] = ptr[i];
+    if(s[i] == ',') s[i] = '.';
+  }
+  s[n] = '\0';
+
+  /* Parse value. */
+  value = atof(s);
+  if(s != local) free(s);
+  if(value != 0.0) return value;
+
+  /* Check if illegible. */
+  for(i = 0; i < n; i++) {
+    c = ptr[i];
+    if(c == ',') c = '.';
+    if(!flag && isspace(c)) continue;
+    if(flag && isspace(c)) return Row::nan();
+    if(flag && (c == '.')) return Row::nan();
+    if(c == '0') return value;
+    flag = true;
+  }
+  return Row::nan();
 }
 
-/* 
- * Return the new length (not including the terminating 
- * null character).  Replace all sequences of white-space characters
- * with a single '\t' ('\0' if end of line). Line must be a null
- * terminated string.
+/*
+ * Hash code of a character sequence.
  */
-static unsigned int
-trim_line(char* line) {
-  unsigned int i;
-  unsigned int len;
-  char* ptr;
-
-  if((len = strlen(line)) < 1)
-    return len;
-
-  /* Remove unnecessary white-space characters. */
-  line[len] = ' ';
-  ptr = line;
-  for(i = 0; i <= len; i++)
-    if(!isspace((int)(line[i]))) {
-      if((*ptr == '\0') && (ptr > line)) ptr++;
-      *ptr = line[i];
-      ptr++;
-    }
-    else
-      *ptr = '\0';
-
-  /* Replace null separators with tabulator. */
-  len = (int)(ptr - line);
-  for(i = 0; i < len; i++)
-    if(line[i] == '\0') line[i] = '\t';
-  line[len] = '\0';
-  
-  return len;
+unsigned int
+field2code(const char* ptr, size_t n) {
+  uint64_t code = hash<string_view>()(string_view(ptr, n));
+  return (unsigned int)(code ^ (code >> 32));
 }
 
 /*
- *
+ * 64-bit hash code of a data block. The block is consumed eight bytes
+ * at a time, so that large files can be verified quickly.
  */
-int 
-rowcmp(const void* ptr1, const void* ptr2) {
-  bool flag1 = 0;
-  bool flag2 = 0;
-  int i, k;
-  int n_keys;
-  float f1;
-  float f2;
-  string s1;
-  string s2;
-  char* line1;
-  char* line2;
-  int* keycols1;
-  int* keycols2;
-  row_t* r1 = (row_t*)ptr1;
-  row_t* r2 = (row_t*)ptr2;
-
-  n_keys = r1->n_keys;
-  if(n_keys > r2->n_keys) n_keys = r2->n_keys;
-  if(n_keys < 1) return (r1->rank - r2->rank);
-
-  /* Compare key shortcuts. */
-  flag1 = (r1->key_0 == NULL);
-  flag2 = (r2->key_0 == NULL);
-  if(flag1 && flag2) return 0;
-  if(flag1) return -1; 
-  if(flag2) return 1;
-  f1 = atof(r1->key_0);
-  f2 = atof(r2->key_0);
-  if(f1 < f2) return -1;
-  if(f1 > f2) return 1;
-  s1 = string(r1->key_0);
-  s2 = string(r2->key_0);
-  if(s1 < s2) return -1;
-  if(s1 > s2) return 1;
-  if(n_keys < 2) return 0;
-
-  flag1 = (r1->key_1 == NULL);
-  flag2 = (r2->key_1 == NULL);
-  if(flag1 && flag2) return 0;
-  if(flag1) return -1; 
-  if(flag2) return 1; 
-  f1 = atof(r1->key_1);
-  f2 = atof(r2->key_1);
-  if(f1 < f2) return -1;
-  if(f1 > f2) return 1;
-  s1 = string(r1->key_1);
-  s2 = string(r2->key_1);
-  if(s1 < s2) return -1;
-  if(s1 > s2) return 1;
-  if(n_keys < 3) return 0;
-
-  flag1 = (r1->key_2 == NULL);
-  flag2 = (r2->key_2 == NULL);
-  if(flag1 && flag2) return 0;
-  if(flag1) return -1; 
-  if(flag2) return 1; 
-  f1 = atof(r1->key_2);
-  f2 = atof(r2->key_2);
-  if(f1 < f2) return -1;
-  if(f1 > f2) return 1;
-  s1 = string(r1->key_2);
-  s2 = string(r2->key_2);
-  if(s1 < s2) return -1;
-  if(s1 > s2) return 1;
-  if(n_keys < 4) return 0;
- 
-  flag1 = (r1->key_3 == NULL);
-  flag2 = (r2->key_3 == NULL);
-  if(flag1 && flag2) return 0;
-  if(flag1) return -1; 
-  if(flag2) return 1; 
-  f1 = atof(r1->key_3);
-  f2 = atof(r2->key_3);
-  if(f1 < f2) return -1;
-  if(f1 > f2) return 1;
-  s1 = string(r1->key_3);
-  s2 = string(r2->key_3);
-  if(s1 < s2) return -1;
-  if(s1 > s2) return 1;
-  if(n_keys < 5) return 0;
-
-  /* Check that keycols are consistent. */
-  keycols1 = r1->keycols;
-  keycols2 = r2->keycols;
-  for(i = 0; i < n_keys; i++) {
-    if(keycols1[i] != keycols2[i]) {
-      fprintf(stderr, "ERROR! %s at line %d: Invalid program state.\n", 
-	      __FILE__, __LINE__);
-      exit(1);
-    }
-  }
-
-  /* Compare all relevant fields. */
-  k = 0;
-  line1 = r1->line;
-  line2 = r2->line;
-  while((k < r1->n_fields) || (k < r2->n_fields)) {
-    for(i = 4; i < n_keys; i++) {
-      if(keycols1[i] != k) continue;
-      f1 = atof(line1);
-      f2 = atof(line2);
-      if(f1 < f2) return -1;
-      if(f1 > f2) return 1;
-      s1 = string(line1);
-      s2 = string(line2);
-      if(s1 < s2) return -1;
-      if(s1 > s2) return 1;
-    }
-    if(k >= r1->n_fields) line1 = &EmptyChar;
-    else line1 += (strlen(line1) + 1);
-    if(k >= r2->n_fields) line2 = &EmptyChar;
-    else line2 += (strlen(line2) + 1);
-    k++;
+uint64_t
+data2code(const char* ptr, size_t n) {
+  size_t i;
+  uint64_t w;
+  uint64_t code = (0x9E3779B97F4A7C15ULL ^ n);
+  for(i = 0; (i + 8) <= n; i += 8) {
+    memcpy(&w, (ptr + i), 8);
+    code = ((code ^ w)*0xFF51AFD7ED558CCDULL);
+    code ^= (code >> 32);
   }
-  
-  return 0;
+  for(w = 0; i < n; i++)
+    w = ((w << 8) | (unsigned char)(ptr[i]));
+  code = ((code ^ w)*0xC4CEB9FE1A85EC53ULL);
+  code ^= (code >> 29);
+  return code;
 }
@@ -57,28 +57,64 @@ Table::operator[](const int i) const {
   return r;
 }
 
+/*
+ *
+ */
+RowView
+Table::view(const int i) const {
+  TableBuffer* tb = (TableBuffer*)buffer;
+  if(i < 0) return RowView();
+  if(i >= tb->n_rows) return RowView();
+  return RowViewObject(tb->rows + i);
+}
+
 /*
  *
  */
 int
 Table::column(const string& heading) const {
   int i;
-  char* ptr;
+  unsigned int len = heading.length();
+  field_t* f;
   row_t* header;
   TableBuffer* tb = (TableBuffer*)buffer;
   if(tb->n_rows < 1) return -1;
-  if(heading.length() < 1) return -1;
+  if(len < 1) return -1;
 
   header = (row_t*)(tb->rows + tb->rank2locus[0]);
-  ptr = header->line;
   for(i = 0; i < header->n_fields; i++) {
-    if(strcmp(ptr, heading.c_str()) == 0) return i;
-    ptr += (strlen(ptr) + 1);
+    f = (header->fields + i);
+    if(f->length != len) continue;
+    if(memcmp((header->line + f->offset), heading.c_str(), len) == 0)
+      return i;
   }
 
   return -1;
 }
 
+/*
+ *
+ */
+int
+Table::position(const int col) const {
+  TableBuffer* tb = (TableBuffer*)buffer;
+  if(col < 0) return col;
+  if(col >= tb->n_cols) return -1;
+  if(tb->origins == NULL) return col;
+  return tb->origins[col];
+}
+
+/*
+ *
+ */
+ColumnIndex
+Table::index(const int col) const {
+  TableBuffer* tb = (TableBuffer*)buffer;
+  hash_t* h = tb->hash(col);
+  if(h == NULL) return ColumnIndex();
+  return ColumnIndexObject(tb, h);
+}
+
 /*
  *
  */
@@ -91,7 +127,7 @@ Table::id() const {
 /*
  *
  */
-unsigned int
+size_t
 Table::mem_size() const {
   TableBuffer* tb = (TableBuffer*)buffer;
   return tb->buf_size;
@@ -104,7 +140,7 @@ void
 Table::print() const {
   int i, k;
   char sep = '\t';
-  char* ptr;
+  field_t* f;
   TableBuffer* tb = (TableBuffer*)buffer;
   row_t* rows = tb->rows;
 
@@ -112,13 +148,12 @@ Table::print() const {
   else printf("\n(%d):", tb->id_code);
   if(isprint(tb->separator)) sep = tb->separator;
   for(i = 0; i < tb->n_rows; i++) {
-    ptr = rows[i].line;
+    f = rows[i].fields;
     printf("\n[%d]", i);
-    printf("\t%s", ptr);    
-    ptr += (strlen(ptr) + 1);
+    printf("\t%.*s", (int)(f->length), (rows[i].line + f->offset));
     for(k = 1; k < rows[i].n_fields; k++) {
-      printf("%c%s", sep, ptr);    
-      ptr += (strlen(ptr) + 1);
+      f = (rows[i].fields + k);
+      printf("%c%.*s", sep, (int)(f->length), (rows[i].line + f->offset));
     }
   }
   printf("\n");
@@ -0,0 +1,128 @@
+/* file: tablebuffer.hash.cpp
+  Copyright (C) 2008 Ville-Petteri Makinen
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the
+  Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+  CITATION (if not provided by software website)
+    Makinen V-P, software name, URL:http://www.iki.fi/~vpmakine/
+
+  CONTACT (if not provided by citation)
+    Ville-Petteri Makinen
+ 
+    Folkhalsan Research Center
+    Biomedicum Helsinki P.O.Box 63
+    Haartmaninkatu 8 00014, Helsinki, Finland
+    Tel: +358 9 191 25462
+    Fax: +358 9 191 25452
+
+    WWW:   http://www.iki.fi/~vpmakine
+*/
+
+#include "table.h"
+
+#define MAX_BUCKETS ((size_t)1 << 32)
+
+/*
+ * Return the hash index of a column, create it if necessary. Rows are
+ * chained by rank, so the index remains valid when the rows are sorted.
+ * Rows are inserted in ascending rank order, hence every chain lists
+ * the later rows first. The index is built under a lock, so concurrent
+ * first lookups on a shared table see only a complete index.
+ */
+hash_t*
+TableBuffer::hash(const int col) {
+  int rank;
+  unsigned int bucket;
+  size_t i;
+  size_t n_buckets = 2;
+  field_t* f;
+  row_t* row;
+  hash_t* h;
+
+  if(col < 0) return NULL;
+  if(col >= n_cols) return NULL;
+  lock_guard<mutex> guard(hash_lock);
+  if(hashes == NULL) {
+    if((hashes = (hash_t**)calloc(n_cols, sizeof(hash_t*))) == NULL) {
+      fprintf(stderr, "ERROR! %s at line %d: Out of memory.\n",
+	      __FILE__, __LINE__);
+      exit(1);
+    }
+  }
+  if(hashes[col] != NULL) return hashes[col];
+
+  /* Allocate at least two buckets per row. Field codes have 32 bits,
+     so more buckets than codes would be of no use. */
+  if(2*(size_t)n_rows > MAX_BUCKETS) {
+    fprintf(stderr, "ERROR! %s at line %d: Too many rows (%d) to index.\n",
+	    __FILE__, __LINE__, n_rows);
+    exit(1);
+  }
+  while(n_buckets < 2*(size_t)n_rows) n_buckets *= 2;
+  if((h = (hash_t*)malloc(sizeof(hash_t))) == NULL) {
+    fprintf(stderr, "ERROR! %s at line %d: Out of memory.\n",
+	    __FILE__, __LINE__);
+    exit(1);
+  }
+  h->column = col;
+  h->mask = (unsigned int)(n_buckets - 1);
+  h->heads = (int*)malloc(n_buckets*sizeof(int));
+  h->chain = (int*)malloc(n_rows*sizeof(int));
+  h->codes = (unsigned int*)malloc(n_rows*sizeof(unsigned int));
+  if((h->heads == NULL) || (h->chain == NULL) || (h->codes == NULL)) {
+    fprintf(stderr, "ERROR! %s at line %d: Out of memory indexing %d "
+	    "rows.\n", __FILE__, __LINE__, n_rows);
+    exit(1);
+  }
+  for(i = 0; i < n_buckets; i++)
+    h->heads[i] = -1;
+
+  /* Rows without the column are not indexed. */
+  for(rank = 0; rank < n_rows; rank++) {
+    row = (rows + rank2locus[rank]);
+    h->chain[rank] = -1;
+    h->codes[rank] = 0;
+    if(col >= row->n_fields) continue;
+    f = (row->fields + col);
+    h->codes[rank] = field2code((row->line + f->offset), f->length);
+    bucket = (h->codes[rank] & h->mask);
+    h->chain[rank] = h->heads[bucket];
+    h->heads[bucket] = rank;
+  }
+
+  hashes[col] = h;
+  return h;
+}
+
+/*
+ * Return the highest rank with a matching field. If none found, a
+ * negative value is returned.
+ */
+int
+TableBuffer::lookup(const hash_t* h, const char* key, size_t len) const {
+  int rank;
+  unsigned int code = field2code(key, len);
+  field_t* f;
+  row_t* row;
+  for(rank = h->heads[code & h->mask]; rank >= 0; rank = h->chain[rank]) {
+    if(h->codes[rank] != code) continue;
+    row = (rows + rank2locus[rank]);
+    f = (row->fields + h->column);
+    if(f->length != len) continue;
+    if(memcmp((row->line + f->offset), key, len) == 0) return rank;
+  }
+  return -1;
+}
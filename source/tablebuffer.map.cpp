@@ -0,0 +1,86 @@
+/* file: tablebuffer.map.cpp
+  Copyright (C) 2008 Ville-Petteri Makinen
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the
+  Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+  CITATION (if not provided by software website)
+    Makinen V-P, software name, URL:http://www.iki.fi/~vpmakine/
+
+  CONTACT (if not provided by citation)
+    Ville-Petteri Makinen
+ 
+    Folkhalsan Research Center
+    Biomedicum Helsinki P.O.Box 63
+    Haartmaninkatu 8 00014, Helsinki, Finland
+    Tel: +358 9 191 25462
+    Fax: +358 9 191 25452
+
+    WWW:   http://www.iki.fi/~vpmakine
+*/
+
+#include "table.h"
+
+/*
+ * Map a regular file into memory. The mapping is read-only and the
+ * contents are indexed in place, so no bytes are copied. Return false
+ * if the file is not suitable (e.g. pipe or empty file).
+ */
+bool
+TableBuffer::map(const char* fname) {
+#ifndef _WIN32
+  int fd;
+  void* ptr;
+  struct stat st;
+
+  if((fd = open(fname, O_RDONLY)) < 0) return false;
+  if((fstat(fd, &st) != 0) || !S_ISREG(st.st_mode) || (st.st_size < 1) ||
+     ((unsigned long long)(st.st_size) > SIZE_MAX)) {
+    close(fd);
+    return false;
+  }
+
+  /* The descriptor is not needed once the pages are mapped. */
+  ptr = mmap(NULL, (size_t)(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if(ptr == MAP_FAILED) return false;
+  madvise(ptr, (size_t)(st.st_size), MADV_SEQUENTIAL);
+
+  release();
+  buf = (char*)ptr;
+  n_bytes = (size_t)(st.st_size);
+  map_size = n_bytes;
+  return true;
+#else
+  return false;
+#endif
+}
+
+/*
+ * Free or unmap the raw data.
+ */
+void
+TableBuffer::release() {
+  if(buf == NULL) return;
+#ifndef _WIN32
+  if(map_size > 0) munmap(buf, map_size);
+  else free(buf);
+#else
+  free(buf);
+#endif
+  buf = NULL;
+  n_bytes = 0;
+  map_size = 0;
+}
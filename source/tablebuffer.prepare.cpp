@@ -33,34 +33,69 @@
 
 #include "table.h"
 
-extern char*        trim_buffer(char*, int*);
-extern char*        tidy_buffer(char*, int*, char);
-extern unsigned int finish_buffer(char*, row_t*, unsigned int, char);
+extern unsigned int index_buffer(const char*, size_t, char,
+				 const vector<char>*, unsigned int,
+				 row_t**, field_t**, int*);
+extern void project_header(const char*, size_t, char,
+			   const vector<string>&, vector<char>&);
 
 /*
- *
+ * Create the row and field indices. If a projection is given, the
+ * selected fields are copied to a compact private buffer and the raw
+ * data is released.
  */
 void
-TableBuffer::prepare(const char sep) {
-  int i;
+TableBuffer::prepare(const char sep, const vector<string>* projection) {
+  int i, j;
+  char* data;
+  char* ptr;
+  field_t* f;
+  vector<char> keep;
 
   /* Standardize separator. */
-  if(sep != '\0') {
-    separator = sep;
-    buf = tidy_buffer(buf, &n_rows, separator);
-  }
-  else {
-    buf = trim_buffer(buf, &n_rows);
-    separator = '\t';
+  separator = sep;
+  if(sep == '\0') separator = '\t';
+
+  /* Translate headings into a column mask and remember the
+     original position of each selected column. */
+  if(projection != NULL) {
+    project_header(buf, n_bytes, sep, *projection, keep);
+    origins = (int*)malloc((keep.size() + 1)*sizeof(int));
+    for(i = 0, j = 0; i < (int)(keep.size()); i++)
+      if(keep[i]) origins[j++] = i;
   }
+
+  /* Create database. The raw data is left intact. */
+  n_cols = index_buffer(buf, n_bytes, sep, (projection ? &keep : NULL),
+			n_threads, &rows, &fields, &n_rows);
   if(n_rows < 1) return;
-  
-  /* Create database. */
   rank2locus = (int*)malloc(n_rows*sizeof(int));
-  rows = (row_t*)malloc(n_rows*sizeof(row_t));
-  n_cols = finish_buffer(buf, rows, n_rows, separator);
   for(i = 0; i < n_rows; i++) {
     rank2locus[i] = i;
     buf_size += rows[i].size;
   }
+  if(projection == NULL) return;
+
+  /* Keep only the projected bytes. */
+  if((data = (char*)malloc(buf_size + 1)) == NULL) {
+    fprintf(stderr, "ERROR! %s at line %d: Out of memory.\n",
+	    __FILE__, __LINE__);
+    exit(1);
+  }
+  ptr = data;
+  for(i = 0; i < n_rows; i++) {
+    char* line = ptr;
+    for(j = 0; j < rows[i].n_fields; j++) {
+      f = (rows[i].fields + j);
+      memcpy(ptr, (rows[i].line + f->offset), f->length);
+      f->offset = (unsigned int)(ptr - line);
+      ptr += f->length;
+      *ptr++ = separator;
+    }
+    rows[i].line = line;
+  }
+  *ptr = '\0';
+  release();
+  buf = data;
+  n_bytes = buf_size;
 }
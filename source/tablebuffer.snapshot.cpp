@@ -0,0 +1,292 @@
+/* file: tablebuffer.snapshot.cpp
+  Copyright (C) 2008 Ville-Petteri Makinen
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the
+  Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+  CITATION (if not provided by software website)
+    Makinen V-P, software name, URL:http://www.iki.fi/~vpmakine/
+
+  CONTACT (if not provided by citation)
+    Ville-Petteri Makinen
+ 
+    Folkhalsan Research Center
+    Biomedicum Helsinki P.O.Box 63
+    Haartmaninkatu 8 00014, Helsinki, Finland
+    Tel: +358 9 191 25462
+    Fax: +358 9 191 25452
+
+    WWW:   http://www.iki.fi/~vpmakine
+*/
+
+#include "table.h"
+
+#define SNAPSHOT_MAGIC   "CFTABLE"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_SUFFIX  ".snapshot"
+
+static uint64_t align(uint64_t);
+
+/*
+ * Replace the mapped source data with a snapshot of the parsed table.
+ * The snapshot is accepted only if it was made from a file with the
+ * same size, modification time and contents, and with the same
+ * separator and projection (encoded in the key). The snapshot itself
+ * is verified by its own hash code. Return false if the snapshot is
+ * missing, damaged or stale, or if memory runs out, the source data is
+ * then left intact.
+ */
+bool
+TableBuffer::restore(const char* fname, uint64_t key) {
+#ifndef _WIN32
+  int i, fd;
+  uint64_t k, n, total;
+  void* ptr;
+  char* base;
+  struct stat st;
+  struct stat info;
+  snapshot_t* hdr;
+  snaprow_t* srows;
+  field_t* f;
+  row_t* new_rows = NULL;
+  int* new_ranks = NULL;
+  int* new_origins = NULL;
+  string path = (string(fname) + SNAPSHOT_SUFFIX);
+
+  /* Source data must be mapped. */
+  if((buf == NULL) || (map_size < 1)) return false;
+  if(stat(fname, &st) != 0) return false;
+  checksum = data2code(buf, n_bytes);
+
+  /* Map snapshot. */
+  if((fd = open(path.c_str(), O_RDONLY)) < 0) return false;
+  if((fstat(fd, &info) != 0) || !S_ISREG(info.st_mode) ||
+     ((unsigned long long)(info.st_size) < sizeof(snapshot_t)) ||
+     ((unsigned long long)(info.st_size) > SIZE_MAX)) {
+    close(fd);
+    return false;
+  }
+  total = (uint64_t)(info.st_size);
+  ptr = mmap(NULL, (size_t)total, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if(ptr == MAP_FAILED) return false;
+  base = (char*)ptr;
+  hdr = (snapshot_t*)ptr;
+
+  /* Check source and layout. */
+  bool flag = (memcmp(hdr->magic, SNAPSHOT_MAGIC, 8) == 0);
+  flag = (flag && (hdr->version == SNAPSHOT_VERSION));
+  flag = (flag && (hdr->header_size == sizeof(snapshot_t)));
+  flag = (flag && (hdr->source_size == (uint64_t)(st.st_size)));
+  flag = (flag && (hdr->source_mtime == (int64_t)(st.st_mtime)));
+  flag = (flag && (hdr->source_code == checksum));
+  flag = (flag && (hdr->key == key));
+  flag = (flag && (hdr->snapshot_code ==
+		   data2code((base + sizeof(snapshot_t)),
+			     (size_t)(total - sizeof(snapshot_t)))));
+  flag = (flag && (hdr->n_rows > 0) && (hdr->n_cols >= 0));
+  flag = (flag && (hdr->n_origins >= 0) && (hdr->n_origins <= hdr->n_cols));
+  flag = (flag && (hdr->data_offset >= sizeof(snapshot_t)));
+  flag = (flag && (hdr->data_size <= total));
+  flag = (flag && (hdr->data_offset <= (total - hdr->data_size)));
+  n = (uint64_t)(hdr->n_rows)*sizeof(snaprow_t);
+  flag = (flag && (hdr->rows_offset <= total) &&
+	  (n <= (total - hdr->rows_offset)));
+  n = (hdr->n_fields)*sizeof(field_t);
+  flag = (flag && (hdr->n_fields <= (total/sizeof(field_t))) &&
+	  (hdr->fields_offset <= total) &&
+	  (n <= (total - hdr->fields_offset)));
+  n = (uint64_t)(hdr->n_origins)*sizeof(int32_t);
+  flag = (flag && (hdr->origins_offset <= total) &&
+	  (n <= (total - hdr->origins_offset)));
+  if(!flag) {
+    munmap(ptr, (size_t)total);
+    return false;
+  }
+
+  /* Check that rows and fields stay within the data block. */
+  srows = (snaprow_t*)(base + hdr->rows_offset);
+  f = (field_t*)(base + hdr->fields_offset);
+  for(i = 0; flag && (i < hdr->n_rows); i++) {
+    snaprow_t& r = srows[i];
+    flag = ((r.n_fields >= 0) && (r.n_fields <= hdr->n_cols));
+    flag = (flag && (r.first_field <= hdr->n_fields));
+    flag = (flag && ((uint64_t)(r.n_fields) <=
+		     (hdr->n_fields - r.first_field)));
+    flag = (flag && (r.line <= hdr->data_size) && (r.rank == i));
+    for(k = 0; flag && (k < (uint64_t)(r.n_fields)); k++) {
+      field_t& fk = f[r.first_field + k];
+      n = ((uint64_t)(fk.offset) + fk.length);
+      flag = (n <= (hdr->data_size - r.line));
+    }
+  }
+  if(!flag) {
+    munmap(ptr, (size_t)total);
+    return false;
+  }
+
+  /* Allocate row tables. */
+  new_rows = (row_t*)malloc((hdr->n_rows)*sizeof(row_t));
+  new_ranks = (int*)malloc((hdr->n_rows)*sizeof(int));
+  if(hdr->n_origins > 0)
+    new_origins = (int*)malloc((hdr->n_origins)*sizeof(int));
+  flag = ((new_rows != NULL) && (new_ranks != NULL));
+  flag = (flag && ((hdr->n_origins < 1) || (new_origins != NULL)));
+  if(!flag) {
+    free(new_rows);
+    free(new_ranks);
+    free(new_origins);
+    munmap(ptr, (size_t)total);
+    return false;
+  }
+
+  /* Use snapshot in place of the source data. */
+  release();
+  buf = base;
+  n_bytes = (size_t)total;
+  map_size = (size_t)total;
+  separator = hdr->separator;
+  n_rows = hdr->n_rows;
+  n_cols = hdr->n_cols;
+  fields = f;
+  shared_fields = true;
+  rows = new_rows;
+  rank2locus = new_ranks;
+  for(i = 0; i < n_rows; i++) {
+    rows[i].rank = srows[i].rank;
+    rows[i].n_fields = srows[i].n_fields;
+    rows[i].size = (size_t)(srows[i].size);
+    rows[i].line = (base + hdr->data_offset + srows[i].line);
+    rows[i].fields = (fields + srows[i].first_field);
+    rank2locus[i] = i;
+    buf_size += rows[i].size;
+  }
+  if(hdr->n_origins > 0) {
+    origins = new_origins;
+    memcpy(origins, (base + hdr->origins_offset),
+	   (hdr->n_origins)*sizeof(int32_t));
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+/*
+ * Write a snapshot of a freshly prepared table next to the source
+ * file. Field contents are packed row by row. The snapshot is written
+ * to a temporary file that is renamed when complete, failures are
+ * silently ignored.
+ */
+void
+TableBuffer::store(const char* fname, uint64_t key) {
+#ifndef _WIN32
+  int i, j;
+  uint64_t pos, n_fields, n_total;
+  struct stat st;
+  snapshot_t* hdr;
+  snaprow_t* srows;
+  field_t* packed;
+  row_t* row;
+  field_t* f;
+  char* data;
+  char* ptr;
+  FILE* output;
+  char tmp[32];
+  string path = (string(fname) + SNAPSHOT_SUFFIX);
+
+  if(n_rows < 1) return;
+  if(stat(fname, &st) != 0) return;
+
+  /* Determine layout. */
+  for(i = 0, n_fields = 0; i < n_rows; i++)
+    n_fields += rows[i].n_fields;
+  snapshot_t h;
+  memset(&h, 0, sizeof(snapshot_t));
+  h.n_fields = n_fields;
+  h.n_origins = ((origins != NULL) ? n_cols : 0);
+  h.data_offset = align(sizeof(snapshot_t));
+  h.data_size = buf_size;
+  h.rows_offset = align(h.data_offset + h.data_size);
+  h.fields_offset = (h.rows_offset + n_rows*sizeof(snaprow_t));
+  h.origins_offset = (h.fields_offset + n_fields*sizeof(field_t));
+  n_total = (h.origins_offset + (h.n_origins)*sizeof(int32_t));
+  if(n_total > SIZE_MAX) return;
+  if((data = (char*)calloc((size_t)n_total, 1)) == NULL) return;
+  hdr = (snapshot_t*)data;
+  *hdr = h;
+
+  /* Pack rows in original order. */
+  srows = (snaprow_t*)(data + hdr->rows_offset);
+  packed = (field_t*)(data + hdr->fields_offset);
+  ptr = (data + hdr->data_offset);
+  for(i = 0, pos = 0, n_fields = 0; i < n_rows; i++) {
+    row = (rows + rank2locus[i]);
+    srows[i].rank = i;
+    srows[i].n_fields = row->n_fields;
+    srows[i].size = row->size;
+    srows[i].line = pos;
+    srows[i].first_field = n_fields;
+    for(j = 0; j < row->n_fields; j++, n_fields++) {
+      f = (row->fields + j);
+      packed[n_fields].offset = (unsigned int)(pos - srows[i].line);
+      packed[n_fields].length = f->length;
+      memcpy(ptr + pos, (row->line + f->offset), f->length);
+      pos += f->length;
+      ptr[pos++] = separator;
+    }
+  }
+  for(i = 0; i < hdr->n_origins; i++) {
+    int32_t k = origins[i];
+    memcpy((data + hdr->origins_offset + i*sizeof(int32_t)), &k,
+	   sizeof(int32_t));
+  }
+
+  /* Header. */
+  memcpy(hdr->magic, SNAPSHOT_MAGIC, 8);
+  hdr->version = SNAPSHOT_VERSION;
+  hdr->header_size = sizeof(snapshot_t);
+  hdr->source_size = (uint64_t)(st.st_size);
+  hdr->source_mtime = (int64_t)(st.st_mtime);
+  hdr->source_code = checksum;
+  hdr->key = key;
+  hdr->n_rows = n_rows;
+  hdr->n_cols = n_cols;
+  hdr->separator = separator;
+  hdr->snapshot_code = data2code((data + sizeof(snapshot_t)),
+				 (size_t)(n_total - sizeof(snapshot_t)));
+
+  /* Write temporary file and replace previous snapshot. */
+  sprintf(tmp, ".%d.tmp", (int)getpid());
+  string tmp_path = (path + tmp);
+  if((output = fopen(tmp_path.c_str(), "wb")) == NULL) {
+    free(data);
+    return;
+  }
+  bool flag = (fwrite(data, 1, (size_t)n_total, output) == n_total);
+  flag = ((fclose(output) == 0) && flag);
+  if(!flag || (rename(tmp_path.c_str(), path.c_str()) != 0))
+    unlink(tmp_path.c_str());
+  free(data);
+#endif
+}
+
+/*
+ * Round up to a multiple of eight bytes.
+ */
+static uint64_t
+align(uint64_t n) {
+  return ((n + 7)/8)*8;
+}
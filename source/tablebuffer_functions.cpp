@@ -0,0 +1,504 @@
+/* file: tablebuffer_functions.cpp
+  Copyright (C) 2008 Ville-Petteri Makinen
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the
+  Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+  CITATION (if not provided by software website)
+    Makinen V-P, software name, URL:http://www.iki.fi/~vpmakine/
+
+  CONTACT (if not provided by citation)
+    Ville-Petteri Makinen
+ 
+    Folkhalsan Research Center
+    Biomedicum Helsinki P.O.Box 63
+    Haartmaninkatu 8 00014, Helsinki, Finland
+    Tel: +358 9 191 25462
+    Fax: +358 9 191 25452
+
+    WWW:   http://www.iki.fi/~vpmakine
+*/
+
+#include <atomic>
+#include <thread>
+#include <set>
+#include "table.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SCAN_X86
+#endif
+
+#define BLOCK_SIZE 64
+#define CHUNK_SIZE 4194304
+#define ROW_CAP    1024
+#define FIELD_CAP  8192
+
+typedef uint64_t (*scan_t)(const char*, char);
+
+struct IndexState {
+  char sep;
+  int n_rows;
+  unsigned int n_cols;
+  size_t n_seps;
+  size_t n_fields;
+  size_t first_field;
+  size_t n_pos;
+  size_t row_size;
+  size_t row_cap;
+  size_t field_cap;
+  const char* line;
+  const char* head;
+  row_t* rows;
+  field_t* fields;
+  const vector<char>* keep;
+};
+
+static void     index_chunk(const char*, size_t, char, const vector<char>*,
+			    IndexState*);
+static void     add_field(IndexState*, const char*);
+static void     add_row(IndexState*, const char*);
+static void     out_of_memory(const int, const size_t);
+static uint64_t scan_scalar(const char*, size_t, char);
+static uint64_t scan_block(const char*, char);
+#ifdef SCAN_X86
+#ifdef __SSE2__
+static uint64_t scan_sse2(const char*, char);
+#endif
+static uint64_t scan_avx2(const char*, char);
+#endif
+static scan_t   select_scanner();
+
+/*
+ * Create row and field indices for a raw buffer without modifying it.
+ * Lines are separated by newline or carriage return characters and
+ * empty lines are ignored. If the separator is '\0', fields are the
+ * maximal sequences of non-white-space characters. Otherwise every
+ * separator starts a new field and lines that contain only separators
+ * are ignored. Return the maximum number of fields per line.
+ *
+ * Large buffers are cut at line breaks into chunks that are indexed
+ * by at most the given number of threads and then joined in the
+ * original order.
+ *
+ * If a column mask is given, only the marked columns are indexed.
+ * Other fields are skipped, but the lines that contain them are kept
+ * as rows.
+ */
+unsigned int
+index_buffer(const char* buf, size_t n_bytes, char sep,
+	     const vector<char>* mask, unsigned int n_threads,
+	     row_t** prows, field_t** pfields, int* num) {
+  unsigned int k;
+  unsigned int n_chunks = 1;
+  size_t i, n_rows, n_fields;
+  unsigned int n_cols = 0;
+  const char* ptr;
+  const char* end = (buf + n_bytes);
+  row_t* rows;
+  field_t* fields;
+
+  /* Cut buffer after line breaks. */
+  if(n_threads > 1) {
+    n_chunks = (unsigned int)(n_bytes/CHUNK_SIZE);
+    if(n_chunks > 4*n_threads) n_chunks = 4*n_threads;
+    if(n_chunks < 1) n_chunks = 1;
+  }
+  vector<const char*> bounds(n_chunks + 1, end);
+  vector<IndexState> chunks(n_chunks);
+  bounds[0] = buf;
+  for(k = 1; k < n_chunks; k++) {
+    ptr = (buf + k*(n_bytes/n_chunks));
+    if(ptr < bounds[k-1]) ptr = bounds[k-1];
+    while((ptr < end) && (*ptr != '\n') && (*ptr != '\r')) ptr++;
+    if(ptr < end) ptr++;
+    bounds[k] = ptr;
+  }
+
+  /* Index chunks. Workers claim the next free chunk until none is
+     left. */
+  if(n_chunks == 1)
+    index_chunk(buf, n_bytes, sep, mask, &(chunks[0]));
+  else {
+    atomic<unsigned int> next(0);
+    vector<thread> workers;
+    if(n_threads > n_chunks) n_threads = n_chunks;
+    for(k = 0; k < n_threads; k++) {
+      workers.push_back(thread([&]() {
+	unsigned int j;
+	while((j = next++) < n_chunks)
+	  index_chunk(bounds[j], (bounds[j+1] - bounds[j]), sep, mask,
+		      &(chunks[j]));
+      }));
+    }
+    for(k = 0; k < n_threads; k++)
+      workers[k].join();
+  }
+
+  /* Count rows and fields. */
+  n_rows = 0;
+  n_fields = 0;
+  for(k = 0; k < n_chunks; k++) {
+    n_rows += chunks[k].n_rows;
+    n_fields += chunks[k].n_fields;
+    if(chunks[k].n_cols > n_cols) n_cols = chunks[k].n_cols;
+  }
+  if(n_rows >= INT_MAX) {
+    fprintf(stderr, "ERROR! %s at line %d: Too many lines.\n",
+	    __FILE__, __LINE__);
+    exit(1);
+  }
+
+  /* Join chunks in original order. */
+  *num = (int)n_rows;
+  if(n_rows < 1) {
+    for(k = 0; k < n_chunks; k++) {
+      free(chunks[k].rows);
+      free(chunks[k].fields);
+    }
+    *prows = NULL;
+    *pfields = NULL;
+    return 0;
+  }
+  if(n_chunks == 1) {
+    rows = (row_t*)realloc(chunks[0].rows, n_rows*sizeof(row_t));
+    if(rows == NULL) out_of_memory(__LINE__, n_rows*sizeof(row_t));
+    fields = (field_t*)realloc(chunks[0].fields,
+			       (n_fields + 1)*sizeof(field_t));
+    if(fields == NULL) out_of_memory(__LINE__, n_fields*sizeof(field_t));
+  }
+  else {
+    rows = (row_t*)malloc(n_rows*sizeof(row_t));
+    if(rows == NULL) out_of_memory(__LINE__, n_rows*sizeof(row_t));
+    fields = (field_t*)malloc((n_fields + 1)*sizeof(field_t));
+    if(fields == NULL) out_of_memory(__LINE__, n_fields*sizeof(field_t));
+    n_rows = 0;
+    n_fields = 0;
+    for(k = 0; k < n_chunks; k++) {
+      IndexState& st = chunks[k];
+      memcpy((rows + n_rows), st.rows, st.n_rows*sizeof(row_t));
+      memcpy((fields + n_fields), st.fields, st.n_fields*sizeof(field_t));
+      for(i = n_rows; i < (n_rows + st.n_rows); i++)
+	rows[i].rank += (int)n_rows;
+      n_rows += st.n_rows;
+      n_fields += st.n_fields;
+      free(st.rows);
+      free(st.fields);
+    }
+  }
+
+  /* Field addresses are final only after the last reallocation. */
+  for(i = 0, n_fields = 0; i < n_rows; i++) {
+    rows[i].fields = (fields + n_fields);
+    n_fields += rows[i].n_fields;
+  }
+
+  *prows = rows;
+  *pfields = fields;
+  return n_cols;
+}
+
+/*
+ * Mark the columns whose headings are listed. The header is the first
+ * line that would be kept as a row.
+ */
+void
+project_header(const char* buf, size_t n_bytes, char sep,
+	const vector<string>& headings, vector<char>& keep) {
+  int i;
+  field_t* f;
+  const char* ptr = buf;
+  const char* eol;
+  const char* end = (buf + n_bytes);
+  set<string> names(headings.begin(), headings.end());
+  IndexState st;
+
+  keep.clear();
+  while(ptr < end) {
+    for(eol = ptr; eol < end; eol++)
+      if((*eol == '\n') || (*eol == '\r')) break;
+    index_chunk(ptr, (eol - ptr), sep, NULL, &st);
+    if(st.n_rows > 0) {
+      keep.resize(st.rows[0].n_fields, 0);
+      for(i = 0; i < st.rows[0].n_fields; i++) {
+	f = (st.fields + i);
+	keep[i] = names.count(string((ptr + f->offset), f->length));
+      }
+    }
+    free(st.rows);
+    free(st.fields);
+    if(st.n_rows > 0) break;
+    ptr = (eol + 1);
+  }
+}
+
+/*
+ * Allocation failures are fatal, as in read_buffer().
+ */
+static void
+out_of_memory(const int line, const size_t n) {
+  fprintf(stderr, "ERROR! %s at line %d: Out of memory allocating %lu "
+	  "bytes.\n", __FILE__, line, (unsigned long)n);
+  exit(1);
+}
+
+/*
+ * Index one chunk. The buffer is scanned in blocks. Each block is
+ * reduced to a bit mask of line breaks and field delimiters, and only
+ * the set bits are visited, so ordinary characters are never touched
+ * one by one. Columns not marked in the optional mask are skipped.
+ */
+static void
+index_chunk(const char* buf, size_t n_bytes, char sep,
+	    const vector<char>* keep, IndexState* st) {
+  size_t base;
+  uint64_t mask;
+  const char* ptr;
+  static scan_t scan = select_scanner();
+
+  st->sep = sep;
+  st->n_rows = 0;
+  st->n_cols = 0;
+  st->n_seps = 0;
+  st->n_fields = 0;
+  st->first_field = 0;
+  st->n_pos = 0;
+  st->row_size = 0;
+  st->row_cap = ROW_CAP;
+  st->field_cap = FIELD_CAP;
+  st->line = buf;
+  st->head = buf;
+  st->rows = (row_t*)malloc(st->row_cap*sizeof(row_t));
+  if(st->rows == NULL) out_of_memory(__LINE__, st->row_cap*sizeof(row_t));
+  st->fields = (field_t*)malloc(st->field_cap*sizeof(field_t));
+  if(st->fields == NULL)
+    out_of_memory(__LINE__, st->field_cap*sizeof(field_t));
+  st->keep = keep;
+
+  /* Visit line breaks and delimiters in order. */
+  for(base = 0; base < n_bytes; base += BLOCK_SIZE) {
+    if((n_bytes - base) >= BLOCK_SIZE) mask = scan(buf + base, sep);
+    else mask = scan_scalar((buf + base), (n_bytes - base), sep);
+    while(mask != 0) {
+      ptr = (buf + base + __builtin_ctzll(mask));
+      mask &= (mask - 1);
+      if((*ptr == '\n') || (*ptr == '\r')) {
+	add_row(st, ptr);
+	continue;
+      }
+      if((sep != '\0') || (ptr > st->head)) add_field(st, ptr);
+      else st->head = (ptr + 1);
+      st->n_seps++;
+    }
+  }
+  add_row(st, (buf + n_bytes));
+}
+
+/*
+ * Append the field that ends at the argument.
+ */
+static void
+add_field(IndexState* st, const char* tail) {
+  size_t pos = (st->n_pos)++;
+  if(st->keep != NULL) {
+    if((pos >= st->keep->size()) || !((*(st->keep))[pos])) {
+      st->head = (tail + 1);
+      return;
+    }
+  }
+  if(st->n_fields >= st->field_cap) {
+    size_t cap = (3*(st->field_cap)/2);
+    field_t* fields = (field_t*)realloc(st->fields, cap*sizeof(field_t));
+    if(fields == NULL) out_of_memory(__LINE__, cap*sizeof(field_t));
+    st->fields = fields;
+    st->field_cap = cap;
+  }
+  st->fields[st->n_fields].offset = (unsigned int)(st->head - st->line);
+  st->fields[st->n_fields].length = (unsigned int)(tail - st->head);
+  st->row_size += (tail - st->head + 1);
+  st->n_fields++;
+  st->head = (tail + 1);
+}
+
+/*
+ * Close the line that ends at the argument. Lines without content
+ * are discarded together with their fields.
+ */
+static void
+add_row(IndexState* st, const char* eol) {
+  unsigned int n;
+  row_t* row;
+
+  /* Last field. Note that separators count as content only in
+     white-space mode, where they are never recorded as fields. */
+  if(eol > st->line) {
+    if((size_t)(eol - st->line) >= INT_MAX) {
+      fprintf(stderr, "ERROR! %s at line %d: Line %d is too long.\n",
+	      __FILE__, __LINE__, (st->n_rows + 1));
+      exit(1);
+    }
+    if(st->sep == '\0') {
+      if(eol > st->head) add_field(st, eol);
+    }
+    else if((size_t)(eol - st->line) > st->n_seps)
+      add_field(st, eol);
+    else {
+      st->n_fields = st->first_field;
+      st->n_pos = 0;
+    }
+  }
+
+  /* Create row. */
+  n = (unsigned int)(st->n_fields - st->first_field);
+  if(st->n_pos > 0) {
+    if(st->n_rows >= INT_MAX) {
+      fprintf(stderr, "ERROR! %s at line %d: Too many lines.\n",
+	      __FILE__, __LINE__);
+      exit(1);
+    }
+    if((size_t)(st->n_rows) >= st->row_cap) {
+      size_t cap = (3*(st->row_cap)/2);
+      row_t* rows = (row_t*)realloc(st->rows, cap*sizeof(row_t));
+      if(rows == NULL) out_of_memory(__LINE__, cap*sizeof(row_t));
+      st->rows = rows;
+      st->row_cap = cap;
+    }
+    row = (st->rows + st->n_rows);
+    row->rank = st->n_rows;
+    row->size = st->row_size;
+    row->n_fields = n;
+    row->line = (char*)(st->line);
+    row->fields = NULL;
+    if(n > st->n_cols) st->n_cols = n;
+    st->n_rows++;
+  }
+
+  /* Start next line. */
+  st->n_seps = 0;
+  st->n_pos = 0;
+  st->row_size = 0;
+  st->first_field = st->n_fields;
+  st->line = (eol + 1);
+  st->head = (eol + 1);
+}
+
+/*
+ * Bit mask of line breaks and delimiters in at most BLOCK_SIZE bytes.
+ * White space is determined as in the "C" locale.
+ */
+static uint64_t
+scan_scalar(const char* ptr, size_t n, char sep) {
+  size_t i;
+  unsigned char c;
+  uint64_t mask = 0;
+  for(i = 0; i < n; i++) {
+    c = (unsigned char)(ptr[i]);
+    if((c == '\n') || (c == '\r')) mask |= ((uint64_t)1 << i);
+    else if(sep != '\0') {
+      if(c == (unsigned char)sep) mask |= ((uint64_t)1 << i);
+    }
+    else if((c == ' ') || ((c >= '\t') && (c <= '\r')))
+      mask |= ((uint64_t)1 << i);
+  }
+  return mask;
+}
+
+/*
+ *
+ */
+static uint64_t
+scan_block(const char* ptr, char sep) {
+  return scan_scalar(ptr, BLOCK_SIZE, sep);
+}
+
+#ifdef SCAN_X86
+#ifdef __SSE2__
+/*
+ *
+ */
+static uint64_t
+scan_sse2(const char* ptr, char sep) {
+  int k;
+  uint64_t mask = 0;
+  __m128i v, t, m;
+  const __m128i nl = _mm_set1_epi8('\n');
+  const __m128i cr = _mm_set1_epi8('\r');
+  const __m128i sp = _mm_set1_epi8(' ');
+  const __m128i ht = _mm_set1_epi8('\t');
+  const __m128i span = _mm_set1_epi8('\r' - '\t');
+  const __m128i delim = _mm_set1_epi8(sep);
+  for(k = 0; k < BLOCK_SIZE; k += 16) {
+    v = _mm_loadu_si128((const __m128i*)(ptr + k));
+    if(sep != '\0') {
+      m = _mm_or_si128(_mm_cmpeq_epi8(v, nl), _mm_cmpeq_epi8(v, cr));
+      m = _mm_or_si128(m, _mm_cmpeq_epi8(v, delim));
+    }
+    else {
+      t = _mm_sub_epi8(v, ht);
+      m = _mm_cmpeq_epi8(_mm_min_epu8(t, span), t);
+      m = _mm_or_si128(m, _mm_cmpeq_epi8(v, sp));
+    }
+    mask |= ((uint64_t)(unsigned int)_mm_movemask_epi8(m) << k);
+  }
+  return mask;
+}
+#endif
+
+/*
+ *
+ */
+__attribute__((target("avx2")))
+static uint64_t
+scan_avx2(const char* ptr, char sep) {
+  int k;
+  uint64_t mask = 0;
+  __m256i v, t, m;
+  const __m256i nl = _mm256_set1_epi8('\n');
+  const __m256i cr = _mm256_set1_epi8('\r');
+  const __m256i sp = _mm256_set1_epi8(' ');
+  const __m256i ht = _mm256_set1_epi8('\t');
+  const __m256i span = _mm256_set1_epi8('\r' - '\t');
+  const __m256i delim = _mm256_set1_epi8(sep);
+  for(k = 0; k < BLOCK_SIZE; k += 32) {
+    v = _mm256_loadu_si256((const __m256i*)(ptr + k));
+    if(sep != '\0') {
+      m = _mm256_or_si256(_mm256_cmpeq_epi8(v, nl), _mm256_cmpeq_epi8(v, cr));
+      m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, delim));
+    }
+    else {
+      t = _mm256_sub_epi8(v, ht);
+      m = _mm256_cmpeq_epi8(_mm256_min_epu8(t, span), t);
+      m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, sp));
+    }
+    mask |= ((uint64_t)(unsigned int)_mm256_movemask_epi8(m) << k);
+  }
+  return mask;
+}
+#endif
+
+/*
+ * Choose the widest scanner supported by the processor.
+ */
+static scan_t
+select_scanner() {
+#ifdef SCAN_X86
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("avx2")) return scan_avx2;
+#ifdef __SSE2__
+  return scan_sse2;
+#endif
+#endif
+  return scan_block;
+}
@@ -35,6 +35,7 @@
 #define tablet_INCLUDED
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 using namespace std;
@@ -58,7 +59,7 @@ namespace tablet {
     std::string operator[](const int) const;
 
     /* Number of characters. */
-    unsigned int mem_size() const;
+    size_t mem_size() const;
 
     /* Floating point value of ith field. If the value is
        illegible, a constant is returned (see nan()). Both the
@@ -75,6 +76,63 @@ namespace tablet {
     static double nan();
   };
 
+  /*
+   * Lightweight reference to a data record inside a table. No data is
+   * copied, so the view is valid only until the table is sorted,
+   * reassigned or destroyed.
+   */
+  class RowView {
+  protected:
+    const void* row;
+  public:
+
+    /* Create an empty view. */
+    RowView();
+
+    /* Return the ith field. If argument is less than zero or more than
+       (size() - 1) empty string is returned.  */
+    std::string_view operator[](const int) const;
+
+    /* Number of characters. */
+    size_t mem_size() const;
+
+    /* Floating point value of ith field, parsed as in Row::number(). */
+    double number(const int) const;
+
+    /* Row index in the original file. */
+    int rank() const;
+
+    /* Number of fields. */
+    unsigned int size() const;
+  };
+
+  /*
+   * Hash index on a table column. The index is owned by the table and
+   * stays valid until the table is reassigned or destroyed. Sorting the
+   * table does not invalidate it.
+   */
+  class ColumnIndex {
+  protected:
+    void* buffer;
+    void* hash;
+  public:
+
+    /* Create an empty index. */
+    ColumnIndex();
+
+    /* Indexed column. If the index is empty, a negative value is
+       returned. */
+    int column() const;
+
+    /* Number of rows whose field is equal to the argument. */
+    unsigned int count(const std::string_view&) const;
+
+    /* Return the row whose field is equal to the argument. If several
+       rows match, the last one in the original file is chosen. If none
+       found, a negative value is returned. */
+    int find(const std::string_view&) const;
+  };
+
   /*
    * Database representation of a text file.
    */
@@ -82,6 +140,8 @@ namespace tablet {
   protected:
     void* buffer;
     string pedigreeFile;
+    void load(const std::string&, const char,
+	      const std::vector<std::string>*);
   public:
     /* Create empty table. */
     Table();
@@ -96,9 +156,24 @@ namespace tablet {
        white space. */
     Table(const std::string&, const char);
 
+    /* As above, but keep only the columns whose headings are listed in
+       the third argument. The columns retain their relative order and
+       the other fields are neither indexed nor stored. */
+    Table(const std::string&, const char, const std::vector<std::string>&);
+
     /* Free resources. */
     ~Table();
 
+    /* Enable or disable binary snapshots. If enabled, the parsed contents
+       of a regular file are stored next to it with the suffix '.snapshot'
+       and reused while the file, the delimiter and the list of headings
+       stay the same. */
+    static void snapshots(const bool);
+
+    /* Set the number of worker threads used to index a large file. If
+       zero, the number of hardware threads is used. */
+    static void threads(const unsigned int);
+
    /* Transfer the contents of the argument to the calling object. Note that
       this does not correspond to duplicating the argument. */
     void operator=(const Table&);
@@ -106,13 +181,17 @@ namespace tablet {
     /* Return the ith row. */
     Row operator[](const int) const;
 
+    /* Return a view to the ith row without copying the data. */
+    RowView view(const int) const;
+
     /* Find the column with the given heading (i.e. field in the
        first row). If none found, a negative values is returned. */
     int column(const std::string&) const;
 
-    /* Find the first occurrence of the first argument in the column
-       indicated by the second argument. Note that the table must be sorted
-       by the given column. If none found, a negative value is returned. */
+    /* Find the last occurrence (in the original file) of the first
+       argument in the column indicated by the second argument. The lookup
+       uses the hash index of the column, so the table need not be sorted.
+       If none found, a negative value is returned. */
     int find(const std::string&, const int) const;
 
     /* Find the first occurence of a row that matches the fields given by
@@ -121,8 +200,18 @@ namespace tablet {
     std::vector<int> find(const std::vector<std::string>&,
 			  const std::vector<int>&) const;
 
+    /* Return the position in the source file of the column given by
+       the argument. The two differ only if the table was loaded with
+       a list of headings. */
+    int position(const int) const;
+
+    /* Return the hash index of the column given by the argument. The
+       index is created on first use and kept with the table. Several
+       threads may call this on the same table. */
+    ColumnIndex index(const int) const;
+
     /* Return the total numer of characters consumed by the table. */
-    unsigned int mem_size() const;
+    size_t mem_size() const;
 
     /* Unique identification. */
     unsigned int id() const;
@@ -172,8 +261,9 @@ namespace tablet {
        white space.*/
     ConfigTable(const std::string&, const char);
 
-    /* Return the row with the argument as first field. If none found, 
-       an empty row is returned. */
+    /* Return the row with the argument as first field. If several rows
+       match, the last one in the file is chosen. If none found, an empty
+       row is returned. */
     Row operator[](const std::string&) const;
 
     /* Return the jth row with the first argument as the first
@@ -181,6 +271,14 @@ namespace tablet {
        returned. */
     Row get(const std::string&, const int) const;
 
+    /* Return the number of rows with the argument as the first field. */
+    unsigned int count(const std::string&) const;
+
+    /* Return the numeric value of the jth field of the row given by
+       operator[]. If the field is empty or not a number, Row::nan() is
+       returned. */
+    double number(const std::string&, const int) const;
+
     /* Find which alternative of a list of strings matches with the
       jth field of the row pointed by the first argument. The second argument
       specifies the number of strings that are listed by subsequent